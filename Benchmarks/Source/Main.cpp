@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    Tutorial_EQ_Benchmarks: runs the benchmarks headless, with no host, and
+    logs one line per run. Exits with 1 if the startup benchmark missed a
+    budget.
+
+    Usage: Tutorial_EQ_Benchmarks [scaling] [startup] [automation]
+    With no argument, every benchmark runs.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/ScalingBenchmark.h"
+#include "../../Source/StartupBenchmark.h"
+#include "../../Source/AutomationBenchmark.h"
+
+namespace {
+    /*! \brief writeToLog goes to the debugger by default, a console run wants it on stdout */
+    class ConsoleLogger : public juce::Logger
+    {
+        void logMessage(const juce::String& message) override { std::cout << message << std::endl; }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // The processors post async updates, they need a MessageManager
+    ConsoleLogger logger;
+    juce::Logger::setCurrentLogger(&logger);
+
+    juce::StringArray names;
+    for (int i = 1; i < argc; i++) names.add(argv[i]);
+    auto shouldRun = [&names](const char* name) { return names.isEmpty() || names.contains(name); };
+
+    bool withinBudgets = true;
+    if (shouldRun("scaling")) RunAllScalingBenchmarks();
+    if (shouldRun("startup")) withinBudgets = RunAllStartupBenchmarks();
+    if (shouldRun("automation")) RunAllAutomationBenchmarks();
+
+    juce::Logger::setCurrentLogger(nullptr);
+    return withinBudgets ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    Tutorial_EQ_MatchEQ: fits the EQ so the stem sounds like the reference
+    (see MatchEQ.h) and writes the result as a preset, a state the plugin
+    loads with setStateInformation.
+
+    Usage: Tutorial_EQ_MatchEQ <stem> <reference> <preset>
+    Exits with 1 on bad arguments or if a file can't be read or written.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/MatchEQ.h"
+
+namespace {
+    /*! \brief writeToLog goes to the debugger by default, a console run wants it on stdout */
+    class ConsoleLogger : public juce::Logger
+    {
+        void logMessage(const juce::String& message) override { std::cout << message << std::endl; }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    ConsoleLogger logger;
+    juce::Logger::setCurrentLogger(&logger);
+
+    int exitCode = 0;
+    if (argc != 4) {
+        juce::Logger::writeToLog("Usage: Tutorial_EQ_MatchEQ <stem> <reference> <preset>");
+        exitCode = 1;
+    } else {
+        // Relative paths are relative to the working directory, like any command line tool's
+        auto getFile = [](const char* path) { return juce::File::getCurrentWorkingDirectory().getChildFile(path); };
+        const auto result = RunMatchEq(getFile(argv[1]), getFile(argv[2]), getFile(argv[3]));
+        if (result.failed()) {
+            juce::Logger::writeToLog("match EQ: " + result.getErrorMessage());
+            exitCode = 1;
+        }
+    }
+
+    juce::Logger::setCurrentLogger(nullptr);
+    return exitCode;
+}
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    Dense automation benchmark, see AutomationBenchmark.h
+
+  ==============================================================================
+*/
+
+#include "AutomationBenchmark.h"
+#include "PluginProcessor.h"
+
+namespace {
+    constexpr int BlockSizes[] { 64, 256, 1024, 2048 };
+    constexpr auto& MinSubBlocks = AutomationSmoothingSamples;
+    constexpr int WarmupBlocks = 16;
+    constexpr int MeasuredBlocks = 200;
+
+    /*! \brief What getChainSettings reads, the choices too: a slope or design change redesigns every section */
+    constexpr ParamIdx AutomatedParams[] {
+        LowCutFreq, HiCutFreq, PeakFreq, PeakGain, PeakQuality, LowCutSlope, HiCutSlope, DesignMode
+    };
+}
+
+
+// Free functions
+
+AutomationResult RunAutomationBenchmark(int blockSize, int minSubBlock, double sampleRate)
+{
+    constexpr int numChannels = 2;
+    AutomationResult result { blockSize, minSubBlock, 0.0, 0.0, 0.0, 0.0 };
+
+    Tutorial_EQAudioProcessor eq;
+    eq.setGovernorEnabled(false); // Its coarse updates would stop the smoothing under load and hide the worst case
+    eq.setAutomationSmoothing(minSubBlock);
+    eq.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    eq.prepareToPlay(sampleRate, blockSize);
+
+    std::vector<juce::RangedAudioParameter*> params;
+    for (auto idx : AutomatedParams) params.push_back(eq.apvts.getParameter(ParamTable[idx].id));
+
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random rng(0x5eed);
+    auto nextBlock = [&] {
+        // Like a host: the params are set before the block, then it is processed
+        for (auto* param : params) param->setValueNotifyingHost(rng.nextFloat());
+        for (int ch = 0; ch < numChannels; ch++) {
+            auto* data = buffer.getWritePointer(ch);
+            for (int i = 0; i < blockSize; i++) data[i] = 0.25f * (rng.nextFloat() * 2.f - 1.f);
+        }
+    };
+
+    // NOTE: The retired coefficients are freed by the message thread, like in a host it must run between blocks
+    auto dispatchMessages = [] { juce::MessageManager::getInstance()->runDispatchLoopUntil(1); };
+
+    for (int i = 0; i < WarmupBlocks; i++) {
+        nextBlock();
+        eq.processBlock(buffer, midi);
+        dispatchMessages();
+    }
+
+    double totalSeconds = 0.0;
+    for (int i = 0; i < MeasuredBlocks; i++) {
+        dispatchMessages(); // Outside of the measure, with the next block
+        nextBlock();
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        eq.processBlock(buffer, midi);
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        totalSeconds += seconds;
+        result.worstBlockMs = juce::jmax(result.worstBlockMs, seconds * 1000.0);
+    }
+    eq.releaseResources();
+
+    result.meanBlockMs = totalSeconds * 1000.0 / MeasuredBlocks;
+    result.deadlineLoad = (totalSeconds / MeasuredBlocks) / (blockSize / sampleRate);
+    result.redesignsPerSecond = GetNumAutomationSubBlocks(blockSize, minSubBlock) * sampleRate / blockSize;
+    return result;
+}
+
+void RunAllAutomationBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+
+    for (int blockSize : BlockSizes) {
+        for (int minSubBlock : MinSubBlocks) {
+            if (minSubBlock >= blockSize) continue; // One sub-block, same as off
+
+            const auto r = RunAutomationBenchmark(blockSize, minSubBlock, sampleRate);
+            juce::Logger::writeToLog("automation, block " + juce::String(blockSize)
+                                     + ", " + (minSubBlock > 0 ? "sub-blocks >= " + juce::String(minSubBlock) : juce::String("per block"))
+                                     + ": mean " + juce::String(r.meanBlockMs, 3) + " ms"
+                                     + ", worst " + juce::String(r.worstBlockMs, 3) + " ms"
+                                     + ", load " + juce::String(r.deadlineLoad * 100.0, 1) + "%"
+                                     + ", " + juce::String(r.redesignsPerSecond, 0) + " redesigns/s");
+        }
+    }
+}
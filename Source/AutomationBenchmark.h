@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+
+    Dense automation benchmark.
+
+    The worst case of automation smoothing: every param the MonoChain
+    depends on moves on every block, so every sub-block of the ramp is
+    redesigned. Times processBlock per block size and Automation Smoothing
+    length, next to the per block redesign (smoothing off), and reports
+    how many redesigns per second that is.
+
+    Runs in the Tutorial_EQ_Benchmarks console app: "Tutorial_EQ_Benchmarks
+    automation" runs it alone.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+struct AutomationResult {
+    int blockSize;
+    int minSubBlock; // 0: smoothing off, one redesign per block
+    double meanBlockMs, worstBlockMs;
+    double deadlineLoad;       // Mean block time / block duration
+    double redesignsPerSecond;
+};
+
+/*! \brief Times one instance whose params all move on every block */
+AutomationResult RunAutomationBenchmark(int blockSize, int minSubBlock, double sampleRate);
+
+/*! \brief Sweeps block sizes and minimum sub-block lengths, one log line per run */
+void RunAllAutomationBenchmarks();
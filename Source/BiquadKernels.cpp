@@ -0,0 +1,261 @@
+/*
+  ==============================================================================
+
+    Biquad cascade kernels, see BiquadKernels.h
+
+  ==============================================================================
+*/
+
+#include "BiquadKernels.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+// GCC and Clang only emit AVX code in functions marked for it. MSVC emits any intrinsic as is
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+ #define EQ_TARGET(isa) __attribute__((target(isa)))
+#else
+ #define EQ_TARGET(isa)
+#endif
+
+
+namespace {
+    constexpr const char* IsaNames[] { "scalar", "sse2", "avx2", "avx512" };
+    static_assert(std::size(IsaNames) == static_cast<size_t>(KernelIsa::NumIsas), "One name per ISA");
+
+    /*! \brief W consecutive bands of the cascade, one per lane. Missing bands (past the end of the cascade)
+        are identities, so the last group can be partial */
+    template <int W>
+    struct LaneGroup {
+        alignas(64) float b0[W], b1[W], b2[W], a1[W], a2[W];
+        alignas(64) float s1[W], s2[W];
+        int numBands;
+
+        void load(const BiquadCoefs* coefs, const float* z1, const float* z2, int count)
+        {
+            numBands = juce::jmin(W, count);
+            for (int k = 0; k < W; k++) {
+                const BiquadCoefs c = k < numBands ? coefs[k] : BiquadCoefs {};
+                b0[k] = c.b0; b1[k] = c.b1; b2[k] = c.b2; a1[k] = c.a1; a2[k] = c.a2;
+                s1[k] = k < numBands ? z1[k] : 0.f;
+                s2[k] = k < numBands ? z2[k] : 0.f;
+            }
+        }
+
+        void store(float* z1, float* z2)
+        {
+            for (int k = 0; k < numBands; k++) {
+                juce::dsp::util::snapToZero(s1[k]);
+                juce::dsp::util::snapToZero(s2[k]);
+                z1[k] = s1[k];
+                z2[k] = s2[k];
+            }
+        }
+    };
+
+#if JUCE_INTEL
+
+    // NOTE: The three kernels are the same algorithm, only the width and the intrinsics change:
+    //  - Y = b0 X + S1, S1 = b1 X - a1 Y + S2, S2 = b2 X - a2 Y (TDF-II, every lane at once)
+    //  - Multiplies and adds, no FMA: each band rounds like the scalar kernel and IIR::Filter, so every
+    //    kernel gives the same bits (checked by the null tests)
+    //  - States only move in the lanes holding a real sample (k <= t < N + k), i.e. not while
+    //    the pipeline fills (t < W - 1) or drains (t >= N)
+    //  - Y rotated up one lane: lane 0 gets the last band's output (sample t - W + 1),
+    //    and is then replaced by the next input sample
+    // Reads data[t + 1] after writing data[t - W + 1], so it works in place.
+
+    EQ_TARGET("sse2")
+    void ProcessCascadeSSE2(float* data, int numSamples, const BiquadCoefs* coefs, float* s1, float* s2, int numBands)
+    {
+        constexpr int W = 4;
+        LaneGroup<W> g;
+        const __m128 lane = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+
+        for (int first = 0; first < numBands; first += W) {
+            g.load(coefs + first, s1 + first, s2 + first, numBands - first);
+            const __m128 B0 = _mm_load_ps(g.b0), B1 = _mm_load_ps(g.b1), B2 = _mm_load_ps(g.b2);
+            const __m128 A1 = _mm_load_ps(g.a1), A2 = _mm_load_ps(g.a2);
+            __m128 S1 = _mm_load_ps(g.s1), S2 = _mm_load_ps(g.s2);
+            __m128 X = _mm_set_ss(numSamples > 0 ? data[0] : 0.f);
+
+            for (int t = 0; t < numSamples + W - 1; t++) {
+                const __m128 Y = _mm_add_ps(_mm_mul_ps(B0, X), S1);
+                __m128 nS1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(B1, X), _mm_mul_ps(A1, Y)), S2);
+                __m128 nS2 = _mm_sub_ps(_mm_mul_ps(B2, X), _mm_mul_ps(A2, Y));
+                if (t < W - 1 || t >= numSamples) {
+                    const __m128 m = _mm_and_ps(_mm_cmple_ps(lane, _mm_set1_ps((float) t)),
+                                                _mm_cmpgt_ps(lane, _mm_set1_ps((float) (t - numSamples))));
+                    nS1 = _mm_or_ps(_mm_and_ps(m, nS1), _mm_andnot_ps(m, S1));
+                    nS2 = _mm_or_ps(_mm_and_ps(m, nS2), _mm_andnot_ps(m, S2));
+                }
+                S1 = nS1;
+                S2 = nS2;
+
+                const __m128 R = _mm_shuffle_ps(Y, Y, _MM_SHUFFLE(2, 1, 0, 3));
+                if (t >= W - 1) data[t - (W - 1)] = _mm_cvtss_f32(R);
+                X = _mm_move_ss(R, _mm_set_ss(t + 1 < numSamples ? data[t + 1] : 0.f));
+            }
+
+            _mm_store_ps(g.s1, S1);
+            _mm_store_ps(g.s2, S2);
+            g.store(s1 + first, s2 + first);
+        }
+    }
+
+    EQ_TARGET("avx2")
+    void ProcessCascadeAVX2(float* data, int numSamples, const BiquadCoefs* coefs, float* s1, float* s2, int numBands)
+    {
+        constexpr int W = 8;
+        LaneGroup<W> g;
+        const __m256 lane = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+        const __m256i rotateUp = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+
+        for (int first = 0; first < numBands; first += W) {
+            g.load(coefs + first, s1 + first, s2 + first, numBands - first);
+            const __m256 B0 = _mm256_load_ps(g.b0), B1 = _mm256_load_ps(g.b1), B2 = _mm256_load_ps(g.b2);
+            const __m256 A1 = _mm256_load_ps(g.a1), A2 = _mm256_load_ps(g.a2);
+            __m256 S1 = _mm256_load_ps(g.s1), S2 = _mm256_load_ps(g.s2);
+            __m256 X = _mm256_blend_ps(_mm256_setzero_ps(), _mm256_set1_ps(numSamples > 0 ? data[0] : 0.f), 1);
+
+            for (int t = 0; t < numSamples + W - 1; t++) {
+                const __m256 Y = _mm256_add_ps(_mm256_mul_ps(B0, X), S1);
+                __m256 nS1 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(B1, X), _mm256_mul_ps(A1, Y)), S2);
+                __m256 nS2 = _mm256_sub_ps(_mm256_mul_ps(B2, X), _mm256_mul_ps(A2, Y));
+                if (t < W - 1 || t >= numSamples) {
+                    const __m256 m = _mm256_and_ps(_mm256_cmp_ps(lane, _mm256_set1_ps((float) t), _CMP_LE_OQ),
+                                                   _mm256_cmp_ps(lane, _mm256_set1_ps((float) (t - numSamples)), _CMP_GT_OQ));
+                    nS1 = _mm256_blendv_ps(S1, nS1, m);
+                    nS2 = _mm256_blendv_ps(S2, nS2, m);
+                }
+                S1 = nS1;
+                S2 = nS2;
+
+                const __m256 R = _mm256_permutevar8x32_ps(Y, rotateUp);
+                if (t >= W - 1) data[t - (W - 1)] = _mm256_cvtss_f32(R);
+                X = _mm256_blend_ps(R, _mm256_set1_ps(t + 1 < numSamples ? data[t + 1] : 0.f), 1);
+            }
+
+            _mm256_store_ps(g.s1, S1);
+            _mm256_store_ps(g.s2, S2);
+            g.store(s1 + first, s2 + first);
+        }
+    }
+
+    EQ_TARGET("avx512f")
+    void ProcessCascadeAVX512(float* data, int numSamples, const BiquadCoefs* coefs, float* s1, float* s2, int numBands)
+    {
+        constexpr int W = 16;
+        LaneGroup<W> g;
+        const __m512 lane = _mm512_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f, 10.f, 11.f, 12.f, 13.f, 14.f, 15.f);
+        const __m512i rotateUp = _mm512_setr_epi32(15, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14);
+
+        for (int first = 0; first < numBands; first += W) {
+            g.load(coefs + first, s1 + first, s2 + first, numBands - first);
+            const __m512 B0 = _mm512_load_ps(g.b0), B1 = _mm512_load_ps(g.b1), B2 = _mm512_load_ps(g.b2);
+            const __m512 A1 = _mm512_load_ps(g.a1), A2 = _mm512_load_ps(g.a2);
+            __m512 S1 = _mm512_load_ps(g.s1), S2 = _mm512_load_ps(g.s2);
+            __m512 X = _mm512_maskz_mov_ps(1, _mm512_set1_ps(numSamples > 0 ? data[0] : 0.f));
+
+            for (int t = 0; t < numSamples + W - 1; t++) {
+                const __m512 Y = _mm512_add_ps(_mm512_mul_ps(B0, X), S1);
+                const __m512 nS1 = _mm512_add_ps(_mm512_sub_ps(_mm512_mul_ps(B1, X), _mm512_mul_ps(A1, Y)), S2);
+                const __m512 nS2 = _mm512_sub_ps(_mm512_mul_ps(B2, X), _mm512_mul_ps(A2, Y));
+                if (t < W - 1 || t >= numSamples) {
+                    const __mmask16 m = _mm512_cmp_ps_mask(lane, _mm512_set1_ps((float) t), _CMP_LE_OQ)
+                                      & _mm512_cmp_ps_mask(lane, _mm512_set1_ps((float) (t - numSamples)), _CMP_GT_OQ);
+                    S1 = _mm512_mask_mov_ps(S1, m, nS1);
+                    S2 = _mm512_mask_mov_ps(S2, m, nS2);
+                } else {
+                    S1 = nS1;
+                    S2 = nS2;
+                }
+
+                const __m512 R = _mm512_permutexvar_ps(rotateUp, Y);
+                if (t >= W - 1) data[t - (W - 1)] = _mm512_cvtss_f32(R);
+                X = _mm512_mask_mov_ps(R, 1, _mm512_set1_ps(t + 1 < numSamples ? data[t + 1] : 0.f));
+            }
+
+            _mm512_store_ps(g.s1, S1);
+            _mm512_store_ps(g.s2, S2);
+            g.store(s1 + first, s2 + first);
+        }
+    }
+
+#endif
+}
+
+
+// Free functions
+
+void ProcessCascadeScalar(float* data, int numSamples, const BiquadCoefs* coefs, float* s1, float* s2, int numBands)
+{
+    // Band by band: each band's coefs and states stay in registers for the whole block
+    for (int k = 0; k < numBands; k++) {
+        const auto c = coefs[k];
+        float z1 = s1[k], z2 = s2[k];
+
+        // Transposed direct form II
+        for (int n = 0; n < numSamples; n++) {
+            const float x = data[n];
+            const float y = c.b0 * x + z1;
+            z1 = c.b1 * x - c.a1 * y + z2;
+            z2 = c.b2 * x - c.a2 * y;
+            data[n] = y;
+        }
+
+        juce::dsp::util::snapToZero(z1);
+        juce::dsp::util::snapToZero(z2);
+        s1[k] = z1;
+        s2[k] = z2;
+    }
+}
+
+bool IsKernelIsaSupported(KernelIsa isa)
+{
+    switch (isa) {
+    case KernelIsa::Scalar: return true;
+   #if JUCE_INTEL
+    case KernelIsa::SSE2:   return juce::SystemStats::hasSSE2();
+    case KernelIsa::AVX2:   return juce::SystemStats::hasAVX2();
+    case KernelIsa::AVX512: return juce::SystemStats::hasAVX512F();
+   #endif
+    default:                return false;
+    }
+}
+
+const char* GetKernelIsaName(KernelIsa isa)
+{
+    return IsaNames[static_cast<int>(isa)];
+}
+
+KernelIsa SelectKernelIsa()
+{
+    const auto forced = juce::SystemStats::getEnvironmentVariable("TUTORIAL_EQ_KERNEL", {}).trim().toLowerCase();
+    if (forced.isNotEmpty()) {
+        for (int i = 0; i < static_cast<int>(KernelIsa::NumIsas); i++) {
+            const auto isa = static_cast<KernelIsa>(i);
+            if (forced == IsaNames[i] && IsKernelIsaSupported(isa)) return isa;
+        }
+        jassertfalse; // Unknown, or not supported by this CPU: falls back to the best one
+    }
+
+    for (int i = static_cast<int>(KernelIsa::NumIsas) - 1; i > 0; i--) {
+        if (IsKernelIsaSupported(static_cast<KernelIsa>(i))) return static_cast<KernelIsa>(i);
+    }
+    return KernelIsa::Scalar;
+}
+
+CascadeKernel GetCascadeKernel(KernelIsa isa)
+{
+    switch (isa) {
+   #if JUCE_INTEL
+    case KernelIsa::SSE2:   return ProcessCascadeSSE2;
+    case KernelIsa::AVX2:   return ProcessCascadeAVX2;
+    case KernelIsa::AVX512: return ProcessCascadeAVX512;
+   #endif
+    case KernelIsa::Scalar:
+    default:                return ProcessCascadeScalar;
+    }
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    Biquad cascade kernels, one per instruction set, picked at run time.
+
+    The scalar kernel runs the cascade band after band. The SIMD ones run W
+    bands at once (W = 4 for SSE2, 8 for AVX2, 16 for AVX-512), one per
+    lane, as a pipeline: at step t, lane k filters sample t - k, and its
+    output moves to lane k + 1 for the next step. A block of N samples takes
+    N + W - 1 vector steps instead of N * W scalar ones, with no added
+    latency (the pipeline is filled and drained within the block). Every
+    kernel computes each band exactly like IIR::Filter, bit for bit.
+
+    They run the extra bands (MultiBandEQ), and the MonoChains when the
+    Chain Engine param is on "Cascade" (BlockIIRChain with a look ahead of
+    1, "Scalar" runs it through ProcessCascadeScalar). The MonoChain only has 3 playing sections, one per element: the
+    cascade only pays off when they run in one call, i.e. while no element
+    fades in or out.
+
+    Every variant is compiled in the same binary, with per function target
+    attributes. SelectKernelIsa() asks the CPU (CPUID, through SystemStats)
+    for the best one. The TUTORIAL_EQ_KERNEL environment variable (scalar,
+    sse2, avx2 or avx512) forces one, e.g. to compare them on one machine.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+/*! \brief Normalized biquad coefficients (a0 == 1), as used by the TDF-II loop */
+struct BiquadCoefs {
+    float b0 { 1.f }, b1 { 0.f }, b2 { 0.f }, a1 { 0.f }, a2 { 0.f };
+};
+
+enum class KernelIsa {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512,
+    NumIsas
+};
+
+/*! \brief Runs numBands biquads in series over data, in place. s1 and s2 hold one TDF-II state per band,
+    in cascade order, and are updated. Doesn't allocate */
+using CascadeKernel = void (*)(float* data, int numSamples, const BiquadCoefs* coefs, float* s1, float* s2, int numBands);
+
+void ProcessCascadeScalar(float* data, int numSamples, const BiquadCoefs* coefs, float* s1, float* s2, int numBands);
+
+bool IsKernelIsaSupported(KernelIsa isa);
+const char* GetKernelIsaName(KernelIsa isa);
+
+/*! \brief The best supported ISA, unless TUTORIAL_EQ_KERNEL forces a supported one */
+KernelIsa SelectKernelIsa();
+
+CascadeKernel GetCascadeKernel(KernelIsa isa);
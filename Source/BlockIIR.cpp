@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    Block IIR, see BlockIIR.h
+
+  ==============================================================================
+*/
+
+#include "BlockIIR.h"
+
+
+// Class functions
+//==============================================================================
+void BlockIIRChain::reset()
+{
+    for (auto& section : sections4) section.reset();
+    for (auto& section : sections8) section.reset();
+    kernelS1.fill(0.f);
+    kernelS2.fill(0.f);
+}
+
+void BlockIIRChain::resetLookAhead()
+{
+    if (blockSize == 1) {
+        kernelS1.fill(0.f);
+        kernelS2.fill(0.f);
+    } else if (blockSize == 4) {
+        for (auto& section : sections4) section.reset();
+    } else {
+        for (auto& section : sections8) section.reset();
+    }
+}
+
+void BlockIIRChain::copyStatesFrom(const BlockIIRChain& other) noexcept
+{
+    for (size_t i = 0; i < MaxSections; i++) {
+        sections4[i].copyStatesFrom(other.sections4[i]);
+        sections8[i].copyStatesFrom(other.sections8[i]);
+    }
+    kernelS1 = other.kernelS1;
+    kernelS2 = other.kernelS2;
+}
+
+template <int Idx>
+void BlockIIRChain::resetElement()
+{
+    const int numSections = Idx == MonoChainIdx::Peak ? 1 : 4;
+    for (int i = GetFirstSection(Idx); i < GetFirstSection(Idx) + numSections; i++) {
+        sections4[(size_t) i].reset();
+        sections8[(size_t) i].reset();
+        kernelS1[(size_t) i] = kernelS2[(size_t) i] = 0.f;
+    }
+}
+
+void BlockIIRChain::ProcessSection(int section, const Filter& filter, float* data, int numSamples)
+{
+    if (filter.coefficients == nullptr) return;
+    const auto& coefs = filter.coefficients->coefficients;
+
+    if (blockSize == 4) {
+        auto& biquad = sections4[(size_t) section];
+        biquad.setCoefficients(coefs.begin(), coefs.size());
+        biquad.process(data, numSamples);
+    } else {
+        auto& biquad = sections8[(size_t) section];
+        biquad.setCoefficients(coefs.begin(), coefs.size());
+        biquad.process(data, numSamples);
+    }
+}
+
+template <int Idx>
+void BlockIIRChain::GatherElement(const MonoChain& chain)
+{
+    constexpr int first = GetFirstSection(Idx);
+    const auto& element = chain.get<Idx>();
+
+    auto gather = [this](int section, const Filter& filter) {
+        if (filter.coefficients == nullptr) return;
+        const auto& coefs = filter.coefficients->coefficients;
+        cascadeCoefs[(size_t) numCascaded] = ToBiquadCoefs(coefs.begin(), coefs.size());
+        cascadeSections[(size_t) numCascaded] = section;
+        cascadeS1[(size_t) numCascaded] = kernelS1[(size_t) section];
+        cascadeS2[(size_t) numCascaded] = kernelS2[(size_t) section];
+        numCascaded++;
+    };
+
+    if constexpr (Idx == MonoChainIdx::Peak) {
+        gather(first, element);
+    } else {
+        if (!element.template isBypassed<0>()) gather(first + 0, element.template get<0>());
+        if (!element.template isBypassed<1>()) gather(first + 1, element.template get<1>());
+        if (!element.template isBypassed<2>()) gather(first + 2, element.template get<2>());
+        if (!element.template isBypassed<3>()) gather(first + 3, element.template get<3>());
+    }
+}
+
+void BlockIIRChain::GatherChain(const MonoChain& chain)
+{
+    if (!chain.isBypassed<MonoChainIdx::LowCut>()) GatherElement<MonoChainIdx::LowCut>(chain);
+    if (!chain.isBypassed<MonoChainIdx::Peak>()) GatherElement<MonoChainIdx::Peak>(chain);
+    if (!chain.isBypassed<MonoChainIdx::HiCut>()) GatherElement<MonoChainIdx::HiCut>(chain);
+}
+
+void BlockIIRChain::RunCascade(float* data, int numSamples)
+{
+    kernel(data, numSamples, cascadeCoefs.data(), cascadeS1.data(), cascadeS2.data(), numCascaded);
+    ScatterCascade();
+}
+
+void BlockIIRChain::ScatterCascade()
+{
+    for (int i = 0; i < numCascaded; i++) {
+        const auto section = (size_t) cascadeSections[(size_t) i];
+        kernelS1[section] = cascadeS1[(size_t) i];
+        kernelS2[section] = cascadeS2[(size_t) i];
+    }
+    numCascaded = 0;
+}
+
+template <int Idx>
+void BlockIIRChain::processElement(const MonoChain& chain, float* data, int numSamples)
+{
+    // NOTE: Like calling the element's process(): its own bypass flag in the chain is the caller's business
+    if (blockSize == 1) {
+        GatherElement<Idx>(chain);
+        RunCascade(data, numSamples);
+        return;
+    }
+
+    constexpr int first = GetFirstSection(Idx);
+    const auto& element = chain.get<Idx>();
+
+    if constexpr (Idx == MonoChainIdx::Peak) {
+        ProcessSection(first, element, data, numSamples);
+    } else {
+        if (!element.template isBypassed<0>()) ProcessSection(first + 0, element.template get<0>(), data, numSamples);
+        if (!element.template isBypassed<1>()) ProcessSection(first + 1, element.template get<1>(), data, numSamples);
+        if (!element.template isBypassed<2>()) ProcessSection(first + 2, element.template get<2>(), data, numSamples);
+        if (!element.template isBypassed<3>()) ProcessSection(first + 3, element.template get<3>(), data, numSamples);
+    }
+}
+
+void BlockIIRChain::process(const MonoChain& chain, float* data, int numSamples)
+{
+    if (blockSize == 1) {
+        GatherChain(chain);
+        RunCascade(data, numSamples);
+        return;
+    }
+
+    if (!chain.isBypassed<MonoChainIdx::LowCut>()) processElement<MonoChainIdx::LowCut>(chain, data, numSamples);
+    if (!chain.isBypassed<MonoChainIdx::Peak>()) processElement<MonoChainIdx::Peak>(chain, data, numSamples);
+    if (!chain.isBypassed<MonoChainIdx::HiCut>()) processElement<MonoChainIdx::HiCut>(chain, data, numSamples);
+}
+
+void BlockIIRChain::beginSamples(const MonoChain& chain)
+{
+    jassert(blockSize == 1);
+    GatherChain(chain);
+}
+
+void BlockIIRChain::endSamples()
+{
+    // Snapped once per block, like the kernels and IIR::Filter do
+    for (int i = 0; i < numCascaded; i++) {
+        juce::dsp::util::snapToZero(cascadeS1[(size_t) i]);
+        juce::dsp::util::snapToZero(cascadeS2[(size_t) i]);
+    }
+    ScatterCascade();
+}
+
+template void BlockIIRChain::resetElement<MonoChainIdx::LowCut>();
+template void BlockIIRChain::resetElement<MonoChainIdx::Peak>();
+template void BlockIIRChain::resetElement<MonoChainIdx::HiCut>();
+template void BlockIIRChain::processElement<MonoChainIdx::LowCut>(const MonoChain&, float*, int);
+template void BlockIIRChain::processElement<MonoChainIdx::Peak>(const MonoChain&, float*, int);
+template void BlockIIRChain::processElement<MonoChainIdx::HiCut>(const MonoChain&, float*, int);
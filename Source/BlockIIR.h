@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    Block IIR: the MonoChain's biquads advanced K samples at a time.
+
+    A TDF-II biquad is the state space system
+        s[n+1] = A s[n] + B x[n],  y[n] = C s[n] + D x[n]
+    with s = (s1, s2), A = [-a1 1; -a2 0], B = (b1 - a1 b0, b2 - a2 b0),
+    C = (1 0) and D = b0. Unrolled over K samples, the K outputs only depend
+    on the state at the start and the K inputs:
+        y = O s + T x,  s[n+K] = A^K s + N x
+    where T is the lower triangular Toeplitz matrix of the impulse response.
+    So the K outputs of a step are K independent dot products, which the
+    compiler spreads over SIMD lanes, instead of a serial recursion.
+
+    The states are exactly the TDF-II ones, so a block that isn't a multiple
+    of K finishes sample by sample without any conversion.
+
+    With a look ahead of 1, BlockIIRChain runs the sections through a
+    cascade kernel instead (see BiquadKernels.h): float TDF-II, bit for bit
+    what IIR::Filter computes. That is how the scalar engine runs too, so
+    every engine's states are ours, and one chain can take another's in
+    O(1) (copyStatesFrom).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "BiquadKernels.h"
+
+
+/*! \brief Takes JUCE's IIR::Coefficients layout: b0 b1 b2 a1 a2 (2nd order) or b0 b1 a1 (1st order), normalized */
+inline BiquadCoefs ToBiquadCoefs(const float* coefs, int numCoefs) noexcept
+{
+    if (numCoefs >= 5) return { coefs[0], coefs[1], coefs[2], coefs[3], coefs[4] };
+    if (numCoefs >= 3) return { coefs[0], coefs[1], 0.f, coefs[2], 0.f };
+    return {};
+}
+
+/*! \brief One biquad in K-step state space form. Redesigning doesn't allocate */
+template <int K>
+class BlockBiquad
+{
+public:
+    /*! \brief Recomputes the matrices only if the coefficients changed, see ToBiquadCoefs */
+    void setCoefficients(const float* coefs, int numCoefs) noexcept
+    {
+        const BiquadCoefs c = ToBiquadCoefs(coefs, numCoefs);
+        if (isDesigned && c.b0 == current.b0 && c.b1 == current.b1 && c.b2 == current.b2
+            && c.a1 == current.a1 && c.a2 == current.a2) {
+            return;
+        }
+        current = c;
+        isDesigned = true;
+        Design();
+    }
+
+    void reset() noexcept { s1 = s2 = 0.0; }
+    void copyStatesFrom(const BlockBiquad& other) noexcept { s1 = other.s1; s2 = other.s2; }
+
+    void process(float* data, int numSamples) noexcept
+    {
+        int n = 0;
+        for (; n + K <= numSamples; n += K) {
+            float* x = data + n;
+            alignas(32) float y[K];
+
+            // Every output of the step at once: y = O s + T x
+            const float f1 = (float) s1, f2 = (float) s2;
+            for (int i = 0; i < K; i++) y[i] = O1[i] * f1 + O2[i] * f2;
+            for (int j = 0; j < K; j++) {
+                const float xj = x[j];
+                for (int i = 0; i < K; i++) y[i] += T[j][i] * xj; // T[j][i] is 0 for i < j
+            }
+
+            // State K samples later: A^K s + N x. In double, see the members
+            double n1 = AK11 * s1 + AK12 * s2, n2 = AK21 * s1 + AK22 * s2;
+            for (int j = 0; j < K; j++) {
+                n1 += N1[j] * x[j];
+                n2 += N2[j] * x[j];
+            }
+            s1 = n1;
+            s2 = n2;
+
+            for (int i = 0; i < K; i++) x[i] = y[i];
+        }
+
+        // Remainder: same states, plain TDF-II
+        for (; n < numSamples; n++) {
+            const double x = data[n];
+            const double y = current.b0 * x + s1;
+            s1 = current.b1 * x - current.a1 * y + s2;
+            s2 = current.b2 * x - current.a2 * y;
+            data[n] = (float) y;
+        }
+
+        juce::dsp::util::snapToZero(s1);
+        juce::dsp::util::snapToZero(s2);
+    }
+
+private:
+    void Design() noexcept
+    {
+        // In double, the powers of A get close to 1 for low freqs at high rates
+        const double b0 = current.b0, a1 = current.a1, a2 = current.a2;
+        const double B1 = current.b1 - a1 * b0, B2 = current.b2 - a2 * b0;
+
+        // P = A^i, starting from the identity
+        double p11 = 1.0, p12 = 0.0, p21 = 0.0, p22 = 1.0;
+        double h[K] {}; // Impulse response
+        h[0] = b0;
+
+        for (int i = 0; i < K; i++) {
+            // C A^i is the first row of A^i
+            O1[i] = (float) p11;
+            O2[i] = (float) p12;
+            if (i + 1 < K) h[i + 1] = p11 * B1 + p12 * B2; // C A^i B
+
+            // N[K-1-i] = A^i B
+            N1[K - 1 - i] = p11 * B1 + p12 * B2;
+            N2[K - 1 - i] = p21 * B1 + p22 * B2;
+
+            // P = A P
+            const double q11 = -a1 * p11 + p21, q12 = -a1 * p12 + p22;
+            const double q21 = -a2 * p11, q22 = -a2 * p12;
+            p11 = q11; p12 = q12; p21 = q21; p22 = q22;
+        }
+        AK11 = p11; AK12 = p12;
+        AK21 = p21; AK22 = p22;
+
+        for (int j = 0; j < K; j++) {
+            for (int i = 0; i < K; i++) T[j][i] = i >= j ? (float) h[i - j] : 0.f;
+        }
+    }
+
+    BiquadCoefs current;
+    bool isDesigned { false };
+
+    alignas(32) float T[K][K] {};  // T[j] is the response of the K outputs to x[j]
+    alignas(32) float O1[K] {}, O2[K] {}; // Response of the K outputs to s1 and s2
+
+    // The state recursion runs in double: with poles close to 1 (low freqs, high rates), A^K is so close to
+    // the identity that rounding it to float shifts the poles far more than rounding a1 and a2 does
+    double N1[K] {}, N2[K] {};     // Contribution of x[j] to the next s1 and s2
+    double AK11 { 1.0 }, AK12 { 0.0 }, AK21 { 0.0 }, AK22 { 1.0 };
+    double s1 { 0.0 }, s2 { 0.0 };
+};
+
+
+/*! \brief Runs a MonoChain's coefficients (and bypass states) through BlockBiquads, or a cascade kernel.
+    The chain's own filters stay idle, the states live here: reset it wherever the chain is reset */
+class BlockIIRChain
+{
+public:
+    static constexpr int MaxSections = 9; // Low cut (4), peak (1), high cut (4)
+
+    /*! \brief 4 or 8 samples per step, or 1 for the cascade kernel */
+    void prepare(int lookAhead) { setLookAhead(lookAhead); reset(); }
+    /*! \brief Switches the step without clearing anything: each step keeps its own states */
+    void setLookAhead(int lookAhead) noexcept { blockSize = lookAhead == 1 || lookAhead == 4 ? lookAhead : 8; }
+    /*! \brief What a look ahead of 1 runs, ProcessCascadeScalar until set */
+    void setKernel(CascadeKernel newKernel) noexcept { kernel = newKernel; }
+    void reset();
+    /*! \brief Clears the current step's states only */
+    void resetLookAhead();
+    /*! \brief Every step's states become other's, e.g. to bring a chain where another one fed the same input is */
+    void copyStatesFrom(const BlockIIRChain& other) noexcept;
+
+    template <int Idx> void resetElement();
+
+    /*! \brief Processes one MonoChain element, skipping bypassed stages like ProcessorChain does */
+    template <int Idx> void processElement(const MonoChain& chain, float* data, int numSamples);
+
+    /*! \brief The whole chain, as MonoChain::process would */
+    void process(const MonoChain& chain, float* data, int numSamples);
+
+    /*! \brief The whole chain one sample at a time, with a look ahead of 1: beginSamples, processSample
+        for each sample, then endSamples keeps the states. Same maths as the kernels */
+    void beginSamples(const MonoChain& chain);
+    float processSample(float x) noexcept
+    {
+        for (int k = 0; k < numCascaded; k++) {
+            const auto& c = cascadeCoefs[(size_t) k];
+            auto& z1 = cascadeS1[(size_t) k];
+            auto& z2 = cascadeS2[(size_t) k];
+            const float y = c.b0 * x + z1;
+            z1 = c.b1 * x - c.a1 * y + z2;
+            z2 = c.b2 * x - c.a2 * y;
+            x = y;
+        }
+        return x;
+    }
+    void endSamples();
+
+private:
+    void ProcessSection(int section, const Filter& filter, float* data, int numSamples);
+
+    /*! \brief Appends the element's playing sections to the cascade, see RunCascade */
+    template <int Idx> void GatherElement(const MonoChain& chain);
+    /*! \brief Every playing element's, bypassed ones skipped like ProcessorChain does */
+    void GatherChain(const MonoChain& chain);
+    /*! \brief Every gathered section in one kernel call, the SIMD ones run them side by side */
+    void RunCascade(float* data, int numSamples);
+    /*! \brief Gives the gathered states back to their sections */
+    void ScatterCascade();
+
+    int blockSize { 8 };
+    std::array<BlockBiquad<4>, MaxSections> sections4;
+    std::array<BlockBiquad<8>, MaxSections> sections8;
+
+    // Look ahead of 1
+    CascadeKernel kernel { ProcessCascadeScalar };
+    std::array<float, MaxSections> kernelS1 {}, kernelS2 {};
+    std::array<BiquadCoefs, MaxSections> cascadeCoefs {};
+    std::array<int, MaxSections> cascadeSections {};
+    std::array<float, MaxSections> cascadeS1 {}, cascadeS2 {};
+    int numCascaded { 0 };
+};
+
+/*! \brief First section of each MonoChain element in BlockIIRChain */
+constexpr int GetFirstSection(int monoChainIdx)
+{
+    return monoChainIdx == MonoChainIdx::LowCut ? 0 : (monoChainIdx == MonoChainIdx::Peak ? 4 : 5);
+}
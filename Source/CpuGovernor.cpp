@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    CPU governor, see CpuGovernor.h
+
+  ==============================================================================
+*/
+
+#include "CpuGovernor.h"
+
+
+// Class functions
+//==============================================================================
+void CpuGovernor::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    load = 0.f;
+    overSeconds = underSeconds = 0.0;
+    lastEndTicks = 0; // The host may not have called for a while
+    // NOTE: The tier is kept, a machine that was overloaded before the prepare still is
+}
+
+void CpuGovernor::setEnabled(bool shouldBeEnabled) noexcept
+{
+    isEnabled = shouldBeEnabled;
+    if (!shouldBeEnabled && tier.exchange(QualityTier::Full) != QualityTier::Full) {
+        numTierChanges++;
+    }
+}
+
+bool CpuGovernor::update(juce::int64 startTicks, juce::int64 endTicks, int numSamples) noexcept
+{
+    // Off or not, the other instances must see this one's time
+    budget->addBusyTicks(endTicks - startTicks);
+    const auto busyTicks = budget->getBusyTicks();
+
+    const auto previous = getTier();
+    if (!isEnabled) {
+        lastEndTicks = 0; // Turned back on, the first callback only starts the interval
+        if (previous == QualityTier::Full) return false;
+        tier = QualityTier::Full;
+        numTierChanges++;
+        return true;
+    }
+    if (numSamples <= 0 || sampleRate <= 0.0) return false;
+
+    const auto sinceLastEnd = endTicks - lastEndTicks;
+    const auto busySinceLastEnd = busyTicks - lastBusyTicks;
+    const bool isFirstCallback = lastEndTicks == 0;
+    lastEndTicks = endTicks;
+    lastBusyTicks = busyTicks;
+    if (isFirstCallback) return false;
+
+    // NOTE: Callbacks closer than the deadline (a host catching up) still had that long
+    const double deadline = numSamples / sampleRate;
+    const double period = juce::jmax(deadline, juce::Time::highResolutionTicksToSeconds(sinceLastEnd));
+    load += GovernorConfig::LoadSmoothing * ((float) (juce::Time::highResolutionTicksToSeconds(busySinceLastEnd) / period) - load);
+
+    auto next = previous;
+    if (load > GovernorConfig::StepDownLoad) {
+        underSeconds = 0.0;
+        overSeconds += deadline;
+        if (overSeconds >= GovernorConfig::StepDownSeconds && previous != QualityTier::SkipNearNeutral) {
+            next = static_cast<QualityTier>(static_cast<int>(previous) + 1);
+        }
+    } else if (load < GovernorConfig::StepUpLoad) {
+        overSeconds = 0.0;
+        underSeconds += deadline;
+        if (underSeconds >= GovernorConfig::StepUpSeconds && previous != QualityTier::Full) {
+            next = static_cast<QualityTier>(static_cast<int>(previous) - 1);
+        }
+    } else {
+        overSeconds = underSeconds = 0.0; // Hysteresis band
+    }
+
+    if (next == previous) return false;
+
+    // Each step needs its own sustained period
+    overSeconds = underSeconds = 0.0;
+    tier = next;
+    numTierChanges++;
+    return true;
+}
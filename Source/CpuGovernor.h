@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    CPU governor: trades quality for time when the process misses its budget.
+
+    Every instance adds its processBlock time to one process-wide CpuBudget.
+    At each callback, an instance divides what every instance spent since
+    its previous callback by the wall-clock time in between (at least the
+    block's deadline): a session of 100 light instances sharing an audio
+    thread overruns it together, which none of them sees from its own time.
+    The share is smoothed into
+    a load; when it stays over StepDownLoad for StepDownSeconds, the
+    processor drops one QualityTier, and when it stays under StepUpLoad for
+    StepUpSeconds (much longer, so it doesn't oscillate), it climbs back one.
+    Between the two loads nothing moves.
+
+    The CPU Governor param turns it off, and offline renders (isNonRealtime)
+    always run at Full. Every tier change is counted and shown by the
+    editor, and goes to the telemetry slot (see Telemetry.h) along with the
+    load that caused it.
+
+    NOTE: Hosts that run tracks on several audio threads add them up too:
+    the load is pessimistic there, the tiers only step down earlier.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Telemetry.h"
+
+
+/*! \brief Each tier keeps the cuts of the previous ones */
+enum class QualityTier {
+    Full,
+    CoarseUpdates,         // Param changes redesign the coefficients at most every CoarseUpdateSeconds
+    ControlRateModulation, // The dynamic peak's gain is recomputed every ControlInterval samples, not every sample
+    SkipNearNeutral,       // Bands within NearNeutralDb of flat are skipped, not just the flat ones
+    NumTiers
+};
+inline constexpr const char* QualityTierNames[] { "Full", "Coarse updates", "Control rate modulation", "Skip near neutral" };
+static_assert(std::size(QualityTierNames) == static_cast<size_t>(QualityTier::NumTiers), "One name per tier");
+
+namespace GovernorConfig {
+    constexpr float StepDownLoad = 0.75f;
+    constexpr float StepUpLoad = 0.4f;
+    constexpr double StepDownSeconds = 0.1;
+    constexpr double StepUpSeconds = 2.0;
+    constexpr float LoadSmoothing = 0.2f; // Weight of the last block in the load
+
+    constexpr double CoarseUpdateSeconds = 0.03;
+    constexpr int ControlInterval = 16;
+    constexpr float NearNeutralDb = 0.5f;
+}
+
+/*! \brief processBlock time of every instance of the process, held through juce::SharedResourcePointer like
+    SharedResources */
+class CpuBudget
+{
+public:
+    void addBusyTicks(juce::int64 ticks) noexcept { busyTicks.fetch_add(ticks, std::memory_order_relaxed); }
+    juce::int64 getBusyTicks() const noexcept { return busyTicks.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<juce::int64> busyTicks { 0 }; // High resolution ticks, since the first instance
+};
+
+class CpuGovernor
+{
+public:
+    void prepare(double newSampleRate);
+
+    /*! \brief Off: the tier goes back to Full at once and stays there. Safe to call from the audio thread */
+    void setEnabled(bool shouldBeEnabled) noexcept;
+
+    /*! \brief Feeds one block, timed in high resolution ticks. Returns true if the tier changed */
+    bool update(juce::int64 startTicks, juce::int64 endTicks, int numSamples) noexcept;
+
+    QualityTier getTier() const noexcept { return tier.load(std::memory_order_relaxed); }
+    float getLoad() const noexcept { return load; }
+    /*! \brief Since the governor was built, for the editor (and tests) to spot tier changes without telemetry */
+    int getNumTierChanges() const noexcept { return numTierChanges.load(std::memory_order_relaxed); }
+
+    /*! \brief Times a whole processBlock, early returns included, and feeds the governor when it goes out of scope */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(CpuGovernor& g, InstanceTelemetry& t, int samples) noexcept
+            : governor(g), telemetry(t), numSamples(samples), start(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedBlock()
+        {
+            if (governor.update(start, juce::Time::getHighResolutionTicks(), numSamples)) {
+                telemetry.recordTierChange(static_cast<int>(governor.getTier()), governor.getLoad());
+            }
+        }
+
+    private:
+        CpuGovernor& governor;
+        InstanceTelemetry& telemetry;
+        const int numSamples;
+        const juce::int64 start;
+    };
+
+private:
+    double sampleRate { 44100.0 };
+    std::atomic<bool> isEnabled { true };
+    std::atomic<QualityTier> tier { QualityTier::Full }; // Also read by the editor
+    std::atomic<int> numTierChanges { 0 };
+    float load { 0.f };
+    juce::SharedResourcePointer<CpuBudget> budget;
+    juce::int64 lastEndTicks { 0 }, lastBusyTicks { 0 }; // At the previous callback, 0 before the first one
+    double overSeconds { 0.0 }, underSeconds { 0.0 }; // How long the load has been over/under the limits
+};
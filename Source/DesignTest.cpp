@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    Design tests, see DesignTest.h
+
+  ==============================================================================
+*/
+
+#include "DesignTest.h"
+#include "MatchedDesign.h"
+
+namespace {
+    using Coefs = juce::dsp::IIR::Coefficients<float>;
+    using Sections = juce::ReferenceCountedArray<Coefs>;
+
+    constexpr double SampleRates[] { 44100.0, 48000.0 };
+    constexpr double Freqs[] { 100.0, 1000.0, 5000.0, 10000.0, 15000.0, 20000.0 };
+    constexpr double PeakQs[] { 0.3, 0.7, 1.0, 3.0, 10.0 };
+    constexpr double PeakGainsDb[] { -24.0, -12.0, -6.0, 6.0, 12.0, 24.0 };
+    constexpr int CutOrders[] { 2, 4, 6, 8 }; // Slope12 to Slope48
+    constexpr double CutFloorDb = -24.0;      // Deeper in the stop band, both designs are just "very quiet"
+
+    // Bounds from MatchedDesign.h, with some room for the float coefficients
+    constexpr double PeakMaxErrorDb = 1.25;     // Centre up to 10kHz
+    constexpr double PeakTopMaxErrorDb = 4.5;   // Centre up to 20kHz
+    constexpr double CutMaxErrorDb = 4.5;
+    constexpr double MustBeatBilinearFreq = 1000.0; // Under it, both are within float noise of the analog curve
+
+    /*! \brief 20Hz-20kHz, 1% apart */
+    template <typename Callback>
+    void ForEachTestFreq(Callback&& callback)
+    {
+        for (double f = 20.0; f < 20000.0; f *= 1.01) callback(f);
+    }
+
+    double GetSectionsMagnitude(const Sections& sections, double freq, double sampleRate)
+    {
+        double mag = 1.0;
+        for (const auto* section : sections) mag *= section->getMagnitudeForFrequency(freq, sampleRate);
+        return mag;
+    }
+
+    double GetErrorDb(double mag, double analogMag)
+    {
+        return std::abs(juce::Decibels::gainToDecibels(mag, -300.0) - juce::Decibels::gainToDecibels(analogMag, -300.0));
+    }
+
+    DesignTestResult RunPeakTest(double sampleRate, double freq)
+    {
+        DesignTestResult result { "peak", sampleRate, freq, 0.0, 0.0,
+                                  freq <= 10000.0 ? PeakMaxErrorDb : PeakTopMaxErrorDb, false };
+
+        for (double q : PeakQs) {
+            for (double gainDb : PeakGainsDb) {
+                const auto gainFactor = juce::Decibels::decibelsToGain(gainDb);
+                const auto matched = MakeMatchedPeakFilter(sampleRate, (float) freq, (float) q, (float) gainFactor);
+                const auto bilinear = Coefs::makePeakFilter(sampleRate, (float) freq, (float) q, (float) gainFactor);
+
+                ForEachTestFreq([&](double f) {
+                    const double analog = GetAnalogPeakMagnitude(f, freq, q, gainFactor);
+                    result.matchedErrorDb = juce::jmax(result.matchedErrorDb,
+                                                       GetErrorDb(matched->getMagnitudeForFrequency(f, sampleRate), analog));
+                    result.bilinearErrorDb = juce::jmax(result.bilinearErrorDb,
+                                                        GetErrorDb(bilinear->getMagnitudeForFrequency(f, sampleRate), analog));
+                });
+            }
+        }
+        return result;
+    }
+
+    DesignTestResult RunCutTest(double sampleRate, double freq, bool isHighPass)
+    {
+        DesignTestResult result { isHighPass ? "low cut" : "high cut", sampleRate, freq, 0.0, 0.0, CutMaxErrorDb, false };
+
+        for (int order : CutOrders) {
+            const auto matched = DesignMatchedButterworth((float) freq, sampleRate, order, isHighPass);
+            const auto bilinear = isHighPass
+                ? juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod((float) freq, sampleRate, order)
+                : juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod((float) freq, sampleRate, order);
+
+            ForEachTestFreq([&](double f) {
+                const double analog = GetAnalogButterworthMagnitude(f, freq, order, isHighPass);
+                if (juce::Decibels::gainToDecibels(analog, -300.0) < CutFloorDb) return;
+
+                result.matchedErrorDb = juce::jmax(result.matchedErrorDb,
+                                                   GetErrorDb(GetSectionsMagnitude(matched, f, sampleRate), analog));
+                result.bilinearErrorDb = juce::jmax(result.bilinearErrorDb,
+                                                    GetErrorDb(GetSectionsMagnitude(bilinear, f, sampleRate), analog));
+            });
+        }
+        return result;
+    }
+}
+
+
+// Free functions
+
+std::vector<DesignTestResult> RunDesignTests()
+{
+    std::vector<DesignTestResult> results;
+
+    for (double sampleRate : SampleRates) {
+        for (double freq : Freqs) {
+            results.push_back(RunPeakTest(sampleRate, freq));
+            results.push_back(RunCutTest(sampleRate, freq, true));
+            results.push_back(RunCutTest(sampleRate, freq, false));
+        }
+    }
+
+    for (auto& result : results) {
+        const bool mustBeatBilinear = result.freq >= MustBeatBilinearFreq;
+        result.passed = result.matchedErrorDb <= result.maxErrorDb
+                        && (!mustBeatBilinear || result.matchedErrorDb < result.bilinearErrorDb);
+    }
+    return results;
+}
+
+bool RunAllDesignTests()
+{
+    bool allPassed = true;
+
+    for (const auto& result : RunDesignTests()) {
+        juce::Logger::writeToLog(juce::String(result.passed ? "PASS " : "FAIL ")
+                                 + "matched " + result.design + " @ " + juce::String(result.freq, 0) + "Hz, "
+                                 + juce::String(result.sampleRate, 0) + "Hz: max error " + juce::String(result.matchedErrorDb, 2)
+                                 + " dB (bilinear " + juce::String(result.bilinearErrorDb, 2)
+                                 + " dB, bound " + juce::String(result.maxErrorDb, 2) + " dB)");
+        allPassed = allPassed && result.passed;
+    }
+    return allPassed;
+}
@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    Design tests: proof that the matched designs track the analog curves.
+
+    Each design (MatchedDesign.h) is measured against its analog prototype
+    over 20Hz-20kHz, at 44.1 and 48kHz, for centres and corners up to
+    20kHz: bells over a Q and gain grid, cuts over every slope the params
+    offer. The worst deviation must stay under the bounds documented in
+    MatchedDesign.h, and under the bilinear design's (what the Bilinear
+    mode runs) once the centre is in the audible top octaves.
+
+    Runs headless with the null tests, in the Tutorial_EQ_Tests console app.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+struct DesignTestResult {
+    juce::String design;
+    double sampleRate, freq;
+    double matchedErrorDb, bilinearErrorDb, maxErrorDb;
+    bool passed;
+};
+
+/*! \brief Worst deviation of each design from the analog curve, per sample rate and centre / corner freq */
+std::vector<DesignTestResult> RunDesignTests();
+
+/*! \brief Runs every design, logs one line per run. Returns false if any failed */
+bool RunAllDesignTests();
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    Dynamic peak band, see DynamicEQ.h
+
+  ==============================================================================
+*/
+
+#include "DynamicEQ.h"
+
+namespace {
+    constexpr float GlideSeconds = 0.02f;
+    constexpr float Log2ToDb = 6.02059991f;     // 20 log10(2)
+    constexpr double DbToLnAmplitude = 0.057564627324851142; // ln(10) / 40: the bell's A is sqrt of the linear gain
+    constexpr float EnvelopeFloor = 1e-9f;      // -180 dB, keeps the log defined
+
+    float MakeSmoothingCoef(float ms, double sampleRate)
+    {
+        return (float) std::exp(-1.0 / (juce::jmax(0.01, (double) ms) * 0.001 * sampleRate));
+    }
+}
+
+
+// Class functions
+//==============================================================================
+void DynamicPeakBand::prepare(double newSampleRate, const DynamicBandSettings& initial)
+{
+    sampleRate = newSampleRate;
+    freqSmoother.reset(sampleRate, GlideSeconds);
+    gainSmoother.reset(sampleRate, GlideSeconds);
+
+    setParameters(initial);
+    freqSmoother.setCurrentAndTargetValue(freqSmoother.getTargetValue());
+    gainSmoother.setCurrentAndTargetValue(gainSmoother.getTargetValue());
+    UpdateFreq(freqSmoother.getCurrentValue());
+    reset();
+}
+
+void DynamicPeakBand::reset()
+{
+    ic1eq.fill(0.0);
+    ic2eq.fill(0.0);
+    det1.fill(0.f);
+    det2.fill(0.f);
+    envelope = 0.f;
+    samplesToUpdate = 0; // The first sample designs the bell
+}
+
+bool DynamicPeakBand::setParameters(const DynamicBandSettings& newSettings)
+{
+    if (newSettings == settings && attackCoef != 0.f) return false; // attackCoef is 0 until the first call
+
+    settings = newSettings;
+    freqSmoother.setTargetValue(juce::jlimit(1.f, (float) (sampleRate * 0.49), settings.freq));
+    gainSmoother.setTargetValue(settings.gaindB);
+    invQ = 1.f / juce::jmax(0.01f, settings.q);
+    attackCoef = MakeSmoothingCoef(settings.attackMs, sampleRate);
+    releaseCoef = MakeSmoothingCoef(settings.releaseMs, sampleRate);
+    slope = 1.f - 1.f / juce::jmax(1.f, settings.ratio);
+
+    UpdateFreq(freqSmoother.getCurrentValue()); // Q moves the detector too
+    return true;
+}
+
+void DynamicPeakBand::UpdateFreq(float freq) noexcept
+{
+    // NOTE: Padé approximant, accurate to 1e-8 up to 0.49 fs. Called per sample while the freq glides
+    g = juce::dsp::FastMathApproximations::tan(juce::MathConstants<double>::pi * freq / sampleRate);
+
+    const double a1Det = 1.0 / (1.0 + g * (g + invQ));
+    detA1 = (float) a1Det;
+    detA2 = (float) (g * a1Det);
+    detA3 = (float) (g * g * a1Det);
+}
+
+void DynamicPeakBand::process(float* const* channels, int numChannels, const float* const* detector,
+                              int numDetectorChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin(numChannels, MaxChannels);
+    if (numDetectorChannels <= 0) {
+        detector = channels; // Each sample is read before it is filtered
+        numDetectorChannels = numChannels;
+    }
+    numDetectorChannels = juce::jmin(numDetectorChannels, MaxChannels);
+
+    const float range = std::abs(settings.rangedB);
+    const float direction = settings.rangedB < 0.f ? -1.f : 1.f;
+
+    for (int n = 0; n < numSamples; n++) {
+        if (freqSmoother.isSmoothing()) UpdateFreq(freqSmoother.getNextValue());
+        const float staticGaindB = gainSmoother.getNextValue();
+
+        // Linked detector: loudest band passed channel
+        float level = 0.f;
+        for (int ch = 0; ch < numDetectorChannels; ch++) {
+            const float v3 = detector[ch][n] - det2[ch];
+            const float v1 = detA1 * det1[ch] + detA2 * v3;
+            const float v2 = det2[ch] + detA2 * det1[ch] + detA3 * v3;
+            det1[ch] = 2.f * v1 - det1[ch];
+            det2[ch] = 2.f * v2 - det2[ch];
+            level = juce::jmax(level, std::abs(invQ * v1)); // 0 dB at the centre freq
+        }
+        const float coef = level > envelope ? attackCoef : releaseCoef;
+        envelope = level + coef * (envelope - level);
+
+        if (--samplesToUpdate <= 0) {
+            samplesToUpdate = controlInterval;
+
+            // Gain computer, in dB
+            const float overdB = Log2ToDb * FastLog2(envelope + EnvelopeFloor) - settings.thresholddB;
+            const float changedB = overdB > 0.f ? direction * juce::jmin(range, overdB * slope) : 0.f;
+            const float gaindB = juce::jlimit(-MaxGaindB, MaxGaindB, staticGaindB + changedB);
+
+            // Bell coefficients: 2 divisions, no trig
+            const double A = juce::dsp::FastMathApproximations::exp(gaindB * DbToLnAmplitude);
+            const double k = invQ / A;
+            a1 = 1.0 / (1.0 + g * (g + k));
+            a2 = g * a1;
+            a3 = g * a2;
+            m1 = k * (A * A - 1.0);
+        }
+
+        for (int ch = 0; ch < numChannels; ch++) {
+            const double v0 = channels[ch][n];
+            const double v3 = v0 - ic2eq[ch];
+            const double v1 = a1 * ic1eq[ch] + a2 * v3;
+            const double v2 = ic2eq[ch] + a2 * ic1eq[ch] + a3 * v3;
+            ic1eq[ch] = 2.0 * v1 - ic1eq[ch];
+            ic2eq[ch] = 2.0 * v2 - ic2eq[ch];
+            channels[ch][n] = (float) (v0 + m1 * v1);
+        }
+    }
+
+    for (int ch = 0; ch < MaxChannels; ch++) {
+        juce::dsp::util::snapToZero(ic1eq[ch]);
+        juce::dsp::util::snapToZero(ic2eq[ch]);
+        juce::dsp::util::snapToZero(det1[ch]);
+        juce::dsp::util::snapToZero(det2[ch]);
+    }
+}
+
+int DynamicPeakBand::getTailSamples(double floorGain) const
+{
+    // The higher A, the smaller k and the closer the poles get to the unit circle
+    const double maxGaindB = juce::jlimit(-(double) MaxGaindB, (double) MaxGaindB,
+                                          (double) juce::jmax(settings.gaindB, settings.gaindB + settings.rangedB));
+    const double A = std::pow(10.0, maxGaindB / 40.0);
+    const double k = invQ / A;
+    const double gt = std::tan(juce::MathConstants<double>::pi * freqSmoother.getTargetValue() / sampleRate);
+
+    // Bilinear transform of s^2 + k s + 1, normalized
+    const double a0 = 1.0 + gt * k + gt * gt;
+    const double a1 = 2.0 * (gt * gt - 1.0) / a0;
+    const double a2 = (1.0 - gt * k + gt * gt) / a0;
+    return GetDecaySamples(GetBiquadPoleRadius(a1, a2), floorGain);
+}
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    Dynamic peak band: a bell whose gain follows an envelope, per sample.
+
+    An IIR::Coefficients redesign per sample is out of the question, and a
+    direct form biquad whose coefficients jump every sample isn't even
+    guaranteed to stay stable. The band is a TPT (topology preserving
+    transform, a.k.a. trapezoidal) state variable filter instead: its states
+    are the integrators', so they stay meaningful whatever the coefficients
+    do, and a new gain only costs 2 divisions.
+
+    With a constant gain, the bell is the same as the RBJ peak filter that
+    MakePeakFilter designs (k = 1 / (Q A)), so the dynamic band sounds like
+    the static one when its envelope is under the threshold. The null tests
+    check it against an RBJ bell designed and run in double: the Padé exp
+    of the gain leaves ~-123 dB at worst (+22.5 dB).
+
+    The filter runs in double. In float, 1 + g (g + k) loses g's digits at
+    low freqs and high rates: a high Q bell at 50Hz, 192kHz only nulls to
+    -64 dB. Scalar double costs the same as scalar float, but for the two
+    divisions of each update.
+
+    The detector is a band pass at the band's freq, on the band's input or
+    on the sidechain, linked over the channels so the stereo image holds.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MultiBandEQ.h"
+
+
+/*! \brief Everything the dynamic band reads from the params, once per block */
+struct DynamicBandSettings {
+    float freq { 750.f }, gaindB { 0.f }, q { 1.f }; // The static bell, same params as the Peak band
+    float thresholddB { -20.f };
+    float ratio { 2.f };
+    float rangedB { -6.f }; // Max gain change over the static gain. Negative cuts over the threshold, positive boosts
+    float attackMs { 5.f }, releaseMs { 100.f };
+
+    bool operator==(const DynamicBandSettings& other) const
+    {
+        return freq == other.freq && gaindB == other.gaindB && q == other.q && thresholddB == other.thresholddB
+            && ratio == other.ratio && rangedB == other.rangedB && attackMs == other.attackMs
+            && releaseMs == other.releaseMs;
+    }
+    bool operator!=(const DynamicBandSettings& other) const { return !(*this == other); }
+};
+
+/*! \brief log2 from the float's exponent and a 2nd order fit of its mantissa, ~0.03 dB off. x must be > 0 */
+inline float FastLog2(float x) noexcept
+{
+    juce::uint32 bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    const float exponent = (float) ((int) ((bits >> 23) & 0xff) - 128); // The fit below adds the missing 1
+    bits = (bits & 0x007fffffu) | 0x3f800000u; // Mantissa, in [1, 2)
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    return exponent + (-0.34484843f * m + 2.02466578f) * m - 0.67487759f;
+}
+
+/*! \brief Stereo linked dynamic bell. Doesn't allocate once prepared */
+class DynamicPeakBand
+{
+public:
+    static constexpr int MaxChannels = 2;
+    static constexpr float MaxGaindB = 30.f; // Static gain plus range, keeps FastMathApproximations::exp in its range
+
+    /*! \brief Starts at initial, without gliding */
+    void prepare(double newSampleRate, const DynamicBandSettings& initial);
+    void reset();
+
+    /*! \brief Called every block. Freq and gain glide to their new values, the rest applies at once.
+        Returns true if anything changed */
+    bool setParameters(const DynamicBandSettings& newSettings);
+
+    /*! \brief The bell's coefficients follow the envelope every interval samples (1 by default). The detector
+        still runs every sample, only the divisions and exp are saved */
+    void setControlInterval(int interval) noexcept { controlInterval = juce::jmax(1, interval); }
+
+    /*! \brief Filters the channels in place. detector holds numDetectorChannels channels (e.g. the sidechain);
+        with none, the band's own input is the detector */
+    void process(float* const* channels, int numChannels, const float* const* detector, int numDetectorChannels,
+                 int numSamples) noexcept;
+
+    /*! \brief Samples to decay by floorGain at the most resonant gain the envelope can reach */
+    int getTailSamples(double floorGain) const;
+
+private:
+    void UpdateFreq(float freq) noexcept;
+
+    double sampleRate { 44100.0 };
+    DynamicBandSettings settings;
+
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> freqSmoother;
+    juce::SmoothedValue<float> gainSmoother; // Static gain, in dB
+
+    // Filter: g from the freq, k from Q and the gain, sample by sample
+    double g { 0.0 };
+    float invQ { 1.f };
+    std::array<double, MaxChannels> ic1eq {}, ic2eq {}; // Integrator states
+
+    // Detector: constant gain band pass, k = 1 / Q
+    float detA1 { 1.f }, detA2 { 0.f }, detA3 { 0.f };
+    std::array<float, MaxChannels> det1 {}, det2 {};
+
+    float envelope { 0.f };
+    float attackCoef { 0.f }, releaseCoef { 0.f };
+    float slope { 0.5f }; // dB of gain change per dB over the threshold: 1 - 1/ratio
+
+    int controlInterval { 1 };
+    int samplesToUpdate { 0 }; // Carried over blocks
+    double a1 { 1.0 }, a2 { 0.0 }, a3 { 0.0 }, m1 { 0.0 }; // Bell coefficients last computed
+};
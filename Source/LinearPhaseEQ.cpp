@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    Linear phase mode, see LinearPhaseEQ.h
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseEQ.h"
+
+
+class LinearPhaseEQ::DesignJob : public juce::ThreadPoolJob
+{
+public:
+    explicit DesignJob(LinearPhaseEQ& o) : juce::ThreadPoolJob("Linear phase kernel"), owner(o) {}
+
+    JobStatus runJob() override
+    {
+        owner.RunDesignJob();
+        return jobHasFinished;
+    }
+
+private:
+    LinearPhaseEQ& owner;
+};
+
+
+// Free functions
+
+juce::AudioBuffer<float> DesignLinearPhaseKernel(const ChainSettings& cs, const ExtraBandSettings& bands, double sampleRate,
+                                                 int length)
+{
+    const int order = juce::roundToInt(std::log2((double) length));
+    jassert((1 << order) == length); // FFT sizes are powers of 2
+
+    // Same chain as the one RespCurveCmp draws
+    MonoChain chain;
+    ConfigureMonoChain(chain, cs, sampleRate);
+
+    // Real only inverse FFT takes the N/2 + 1 complex bins, interleaved. Imaginary parts stay 0 (zero phase)
+    std::vector<float> data(2 * (size_t) length, 0.f);
+    double magSum = 0.0;
+    for (int k = 0; k <= length / 2; k++) {
+        const double freq = k * sampleRate / length;
+        double mag = GetChainMagnitudeForFrequency(chain, freq, sampleRate);
+        for (const auto& band : bands) {
+            mag *= GetBandMagnitudeForFrequency(band, freq, sampleRate);
+        }
+        data[2 * (size_t) k] = (float) mag;
+        // Every bin but DC and Nyquist has its mirror in the full spectrum
+        magSum += (k == 0 || k == length / 2) ? mag : 2.0 * mag;
+    }
+
+    juce::dsp::FFT fft(order);
+    fft.performRealOnlyInverseTransform(data.data());
+
+    // The centre tap is the mean of the spectrum. Scaling on it makes us independent of the FFT engine's normalisation
+    const double expectedCentre = magSum / length;
+    const float scale = data[0] != 0.f ? (float) (expectedCentre / data[0]) : 1.f / (float) length;
+
+    // Rotate so the zero phase impulse is centred on length / 2, then taper with a periodic Blackman window
+    // (symmetric around length / 2, which keeps the kernel exactly linear phase)
+    juce::AudioBuffer<float> kernel(1, length);
+    auto* taps = kernel.getWritePointer(0);
+    const double twoPiOverN = juce::MathConstants<double>::twoPi / length;
+    for (int n = 0; n < length; n++) {
+        const int src = (n + length / 2) % length;
+        const double window = 0.42 - 0.5 * std::cos(twoPiOverN * n) + 0.08 * std::cos(2.0 * twoPiOverN * n);
+        taps[n] = (float) (data[(size_t) src] * scale * window);
+    }
+
+    return kernel;
+}
+
+
+// Class functions
+//==============================================================================
+LinearPhaseEQ::LinearPhaseEQ()
+{
+    designJob = std::make_unique<DesignJob>(*this);
+}
+
+LinearPhaseEQ::~LinearPhaseEQ()
+{
+    designPool->removeJob(designJob.get(), true, -1);
+}
+
+void LinearPhaseEQ::prepare(const juce::dsp::ProcessSpec& spec, const ChainSettings& cs, const ExtraBandSettings& bands,
+                            int kernelLength, bool isNonRealtime)
+{
+    // No stale kernel (e.g. designed at the old sample rate) must land after the one below
+    designPool->removeJob(designJob.get(), true, -1);
+    {
+        const juce::SpinLock::ScopedLockType lock(jobLock);
+        isJobQueued = false; // Removed before it ran, or done
+    }
+
+    const bool isWarm = spec.sampleRate == preparedSpec.sampleRate && spec.maximumBlockSize == preparedSpec.maximumBlockSize
+        && spec.numChannels == preparedSpec.numChannels;
+    sampleRate = spec.sampleRate;
+    preparedSpec = spec;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(pendingLock);
+        // Warm, the loaded kernel was designed for this rate: only a change of settings needs a new one
+        kernelDirty = !isWarm || cs != lastRequested || bands != lastRequestedBands || kernelLength != lastRequestedLength;
+        lastRequested = pendingSettings = cs;
+        lastRequestedBands = pendingBands = bands;
+        lastRequestedLength = pendingLength = kernelLength;
+    }
+
+    // NOTE: Convolution::prepare builds the engine of the last loaded kernel on the spot, no crossfade:
+    // loaded before it, a kernel plays from the first block
+    if (!isWarm || (isNonRealtime && kernelDirty)) {
+        convolution.loadImpulseResponse(DesignLinearPhaseKernel(cs, bands, spec.sampleRate, kernelLength), spec.sampleRate,
+            juce::dsp::Convolution::Stereo::no, juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::no);
+        convolution.prepare(spec);
+        kernelDirty = false;
+    } else {
+        convolution.reset();
+    }
+
+    if (kernelDirty) notify();
+}
+
+void LinearPhaseEQ::reset()
+{
+    convolution.reset();
+}
+
+void LinearPhaseEQ::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    convolution.process(context);
+}
+
+void LinearPhaseEQ::setTarget(const ChainSettings& cs, const ExtraBandSettings& bands, int kernelLength)
+{
+    {
+        const juce::SpinLock::ScopedTryLockType lock(pendingLock);
+        if (lock.isLocked() && (cs != lastRequested || bands != lastRequestedBands || kernelLength != lastRequestedLength)) {
+            lastRequested = cs;
+            lastRequestedBands = bands;
+            lastRequestedLength = kernelLength;
+            pendingSettings = cs;
+            pendingBands = bands;
+            pendingLength = kernelLength;
+            kernelDirty = true;
+        }
+    }
+    // Every block while a kernel is pending, so a notify that found the job leaving is retried
+    if (kernelDirty) notify();
+}
+
+void LinearPhaseEQ::notify()
+{
+    // NOTE: Holding jobLock, the job is either before its last look at kernelDirty (and sees ours) or done with it
+    const juce::SpinLock::ScopedTryLockType lock(jobLock);
+    if (!lock.isLocked() || isJobQueued) return;
+
+    // Out of its loop but still leaving runJob: the pool would ignore the job, next block queues it
+    if (designPool->contains(designJob.get())) return;
+    isJobQueued = true;
+    designPool->addJob(designJob.get(), false);
+}
+
+void LinearPhaseEQ::RunDesignJob()
+{
+    for (;;) {
+        while (kernelDirty.exchange(false)) {
+            ChainSettings cs;
+            ExtraBandSettings bands;
+            int length;
+            {
+                const juce::SpinLock::ScopedLockType lock(pendingLock);
+                cs = pendingSettings;
+                bands = pendingBands;
+                length = pendingLength;
+            }
+
+            const double sr = sampleRate;
+            // Convolution swaps (and crossfades to) the new kernel on its own, from the audio thread
+            convolution.loadImpulseResponse(DesignLinearPhaseKernel(cs, bands, sr, length), sr,
+                juce::dsp::Convolution::Stereo::no, juce::dsp::Convolution::Trim::no,
+                juce::dsp::Convolution::Normalise::no);
+        }
+
+        const juce::SpinLock::ScopedLockType lock(jobLock);
+        if (!kernelDirty) {
+            isJobQueued = false;
+            return;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    Linear phase mode: the MonoChain's magnitude response (the curve
+    RespCurveCmp draws) turned into a symmetric FIR kernel, and run through
+    juce::dsp::Convolution (uniformly partitioned FFT convolution). The
+    extra bands' magnitudes are folded into the same kernel: run after it,
+    their biquads would bring minimum phase back.
+
+    Kernels are designed by a job on the shared PrepareThreadPool, the audio
+    thread only hands over the target settings and queues the job when it
+    isn't already. Convolution crossfades between the old
+    and the new kernel when one is loaded, so parameter changes don't click.
+    The exceptions are a cold prepare (first one, or new spec) and an
+    offline render: there the kernel is designed in prepare, so the first
+    block is already EQ'd (a bounce must not start flat).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "SharedResources.h"
+
+
+/*! \brief Symmetric (zero phase, delayed by length / 2) FIR kernel with the magnitude response of the MonoChain
+    followed by the extra bands.
+    \note Allocates and runs an FFT, never call from the audio thread */
+juce::AudioBuffer<float> DesignLinearPhaseKernel(const ChainSettings& cs, const ExtraBandSettings& bands, double sampleRate,
+                                                 int length);
+
+
+/*! \brief Created by the processor the first time Phase Mode is Linear, see Tutorial_EQAudioProcessor::linearPhase */
+class LinearPhaseEQ
+{
+public:
+    LinearPhaseEQ();
+    ~LinearPhaseEQ();
+
+    /*! \brief Cold (first prepare, or another spec) or offline, designs the kernel for cs before returning.
+        Otherwise (warm start, realtime), the current kernel keeps playing until the design job's new one lands */
+    void prepare(const juce::dsp::ProcessSpec& spec, const ChainSettings& cs, const ExtraBandSettings& bands, int kernelLength,
+                 bool isNonRealtime);
+    void reset();
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+    /*! \brief Audio thread side: requests a new kernel if the settings, the bands or the length changed, and notifies
+        the job. Never waits, if the job holds a lock the request is retried next block */
+    void setTarget(const ChainSettings& cs, const ExtraBandSettings& bands, int kernelLength);
+
+    /*! \brief Delay added by a kernel of that length, as reported to the host */
+    int getLatencyForLength(int kernelLength) const { return kernelLength / 2 + convolution.getLatency(); }
+
+private:
+    /*! \brief Queues the design job unless it is queued or running, it then takes the pending kernel itself */
+    void notify();
+    /*! \brief The job's body: designs until no request is pending */
+    void RunDesignJob();
+
+    class DesignJob;
+    juce::SharedResourcePointer<PrepareThreadPool> designPool;
+    std::unique_ptr<DesignJob> designJob;
+    juce::SpinLock jobLock;   // Orders notify() against the job's last look at kernelDirty
+    bool isJobQueued { false }; // Guarded by jobLock
+
+    // NOTE: A Convolution makes its own loader thread unless given a queue. One queue for every instance,
+    // so creating a plugin doesn't start a thread
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> convolutionQueue;
+    juce::dsp::Convolution convolution { *convolutionQueue }; // Default: zero latency, uniformly partitioned
+
+    std::atomic<double> sampleRate { 44100.0 };
+    juce::dsp::ProcessSpec preparedSpec { 0.0, 0, 0 };
+
+    juce::SpinLock pendingLock;
+    ChainSettings pendingSettings, lastRequested;
+    ExtraBandSettings pendingBands {}, lastRequestedBands {};
+    int pendingLength { 0 }, lastRequestedLength { 0 };
+    std::atomic<bool> kernelDirty { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LinearPhaseEQ)
+};
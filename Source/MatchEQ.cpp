@@ -0,0 +1,425 @@
+/*
+  ==============================================================================
+
+    Match EQ, see MatchEQ.h
+
+  ==============================================================================
+*/
+
+#include "MatchEQ.h"
+
+namespace {
+    constexpr int FftSize = 1 << MatchEqConfig::FftOrder;
+    constexpr int HopSize = FftSize / 2;
+    constexpr int ChunkSamples = (MatchEqConfig::FramesPerJob - 1) * HopSize + FftSize;
+    constexpr int MaxChannels = 8;
+
+    /*! \brief Runs the FFT frames of one chunk of the file, adds their power to its own sums. Reused chunk after chunk */
+    class SpectrumJob : public juce::ThreadPoolJob
+    {
+    public:
+        explicit SpectrumJob(int numChannels)
+            : juce::ThreadPoolJob("Match EQ spectrum"),
+              chunk(numChannels, ChunkSamples),
+              fft(MatchEqConfig::FftOrder),
+              window((size_t) FftSize, juce::dsp::WindowingFunction<float>::hann, false),
+              fftBuffer((size_t) FftSize * 2, 0.f),
+              power((size_t) FftSize / 2 + 1, 0.0)
+        {
+        }
+
+        juce::AudioBuffer<float> chunk; // Filled by the reading thread before the job is queued
+        int numChunkFrames { 0 };
+
+        std::vector<double> power; // Summed over every frame and channel run so far
+        juce::int64 numFrames { 0 };
+
+        JobStatus runJob() override
+        {
+            for (int frame = 0; frame < numChunkFrames; frame++) {
+                for (int ch = 0; ch < chunk.getNumChannels(); ch++) {
+                    std::copy_n(chunk.getReadPointer(ch, frame * HopSize), FftSize, fftBuffer.begin());
+                    window.multiplyWithWindowingTable(fftBuffer.data(), (size_t) FftSize);
+                    fft.performFrequencyOnlyForwardTransform(fftBuffer.data(), true);
+
+                    for (size_t bin = 0; bin < power.size(); bin++) {
+                        power[bin] += (double) fftBuffer[bin] * fftBuffer[bin];
+                    }
+                }
+            }
+            numFrames += (juce::int64) numChunkFrames * chunk.getNumChannels();
+            return jobHasFinished;
+        }
+
+    private:
+        juce::dsp::FFT fft; // One per job: JUCE's fallback engine serialises the threads sharing one
+        juce::dsp::WindowingFunction<float> window;
+        std::vector<float> fftBuffer;
+    };
+
+
+    // Fit
+    // =====================================
+
+    using Curve = std::vector<double>; // dB, one value per fit point
+
+    /*! \brief Variance of the residual, i.e. the squared error once the best broadband offset is removed */
+    double GetShapeError(const Curve& target, const Curve& others, const Curve& part, double* offset = nullptr)
+    {
+        double sum = 0.0, sumSquares = 0.0;
+        for (size_t i = 0; i < target.size(); i++) {
+            // Floored: the stop band of a steep cut is just "very quiet", its depth doesn't matter
+            const double residual = juce::jmax(others[i] + part[i], -60.0) - target[i];
+            sum += residual;
+            sumSquares += residual * residual;
+        }
+        const double mean = sum / (double) target.size();
+        if (offset != nullptr) *offset = mean;
+        return sumSquares / (double) target.size() - mean * mean;
+    }
+
+    Curve Add(const Curve& a, const Curve& b)
+    {
+        Curve sum(a.size());
+        for (size_t i = 0; i < a.size(); i++) sum[i] = a[i] + b[i];
+        return sum;
+    }
+
+    float Snap(ParamIdx idx, float value)
+    {
+        const auto& desc = ParamTable[idx];
+        return juce::NormalisableRange<float>(desc.minVal, desc.maxVal, desc.interval, desc.skew).snapToLegalValue(value);
+    }
+
+    /*! \brief Where the search tries a freq param, log spaced over its range */
+    std::vector<float> MakeFreqCandidates(ParamIdx idx)
+    {
+        std::vector<float> freqs;
+        const double step = std::pow(2.0, 1.0 / MatchEqConfig::SearchStepsPerOctave);
+        for (double f = ParamTable[idx].minVal; f <= ParamTable[idx].maxVal; f *= step) freqs.push_back(Snap(idx, (float) f));
+        return freqs;
+    }
+
+    class MatchFitter
+    {
+    public:
+        MatchFitter(std::vector<double> pointFreqs, Curve targetDb, double rate)
+            : freqs(std::move(pointFreqs)), target(std::move(targetDb)), sampleRate(rate) {}
+
+        /*! \brief Coarse searches one element at a time (cuts first, they explain the extremes), then a local
+            refinement of the continuous params. From neutral settings */
+        MatchEqFit fit()
+        {
+            ChainSettings cs;
+            cs.lowCutFreq = ParamTable[LowCutFreq].dflt;
+            cs.hiCutFreq = ParamTable[HiCutFreq].dflt;
+            cs.peakFreq = ParamTable[PeakFreq].dflt;
+            cs.peakGaindB = ParamTable[PeakGain].dflt;
+            cs.peakQ = ParamTable[PeakQuality].dflt;
+            cs.designMode = MatchedDesign; // Closest to the analog curves, whatever the session's rate
+
+            MatchEqFit result { cs, 0.0, 0.0, (int) freqs.size() };
+            if (freqs.empty()) return result;
+
+            for (int round = 0; round < MatchEqConfig::FitRounds; round++) {
+                SearchCut(cs, true);
+                SearchCut(cs, false);
+                SearchPeak(cs);
+            }
+            Refine(cs);
+
+            double offset = 0.0;
+            result.settings = cs;
+            result.rmsErrorDb = std::sqrt(juce::jmax(0.0, GetShapeError(target, Curve(freqs.size(), 0.0), GetChainDb(cs), &offset)));
+            result.levelOffsetDb = -offset;
+            return result;
+        }
+
+    private:
+        std::vector<double> freqs;
+        Curve target;
+        double sampleRate;
+        mutable MonoChain chain; // Only designed, never run: candidates are measured as the plugin plays them
+
+        static bool IsCutOff(const ChainSettings& cs, bool isLowCut)
+        {
+            // Parked at the end of its range, where the search starts: it still plays, but nothing decided to move it
+            return isLowCut ? cs.lowCutFreq <= ParamTable[LowCutFreq].minVal : cs.hiCutFreq >= ParamTable[HiCutFreq].maxVal;
+        }
+
+        /*! \brief ConfigureMonoChain, like the processor: a cut runs the one section UpdateCutFilter enables */
+        template <typename MagnitudeFn>
+        Curve Measure(const ChainSettings& cs, MagnitudeFn&& getMagnitude) const
+        {
+            ConfigureMonoChain(chain, cs, sampleRate);
+            Curve curve(freqs.size());
+            for (size_t i = 0; i < freqs.size(); i++) {
+                curve[i] = juce::Decibels::gainToDecibels(getMagnitude(freqs[i]), -300.0);
+            }
+            return curve;
+        }
+
+        Curve GetCutDb(const ChainSettings& cs, bool isLowCut) const
+        {
+            const auto& cut = isLowCut ? chain.get<MonoChainIdx::LowCut>() : chain.get<MonoChainIdx::HiCut>();
+            return Measure(cs, [this, &cut](double freq) { return GetCutFilterMagnitudeForFrequency(cut, freq, sampleRate); });
+        }
+
+        Curve GetPeakDb(const ChainSettings& cs) const
+        {
+            const auto& peak = chain.get<MonoChainIdx::Peak>();
+            return Measure(cs, [this, &peak](double freq) { return peak.coefficients->getMagnitudeForFrequency(freq, sampleRate); });
+        }
+
+        Curve GetChainDb(const ChainSettings& cs) const
+        {
+            return Measure(cs, [this](double freq) { return GetChainMagnitudeForFrequency(chain, freq, sampleRate); });
+        }
+
+        double GetError(const ChainSettings& cs) const
+        {
+            return GetShapeError(target, Curve(freqs.size(), 0.0), GetChainDb(cs));
+        }
+
+        void SearchCut(ChainSettings& cs, bool isLowCut) const
+        {
+            const auto others = Add(GetPeakDb(cs), GetCutDb(cs, !isLowCut));
+            const ParamIdx freqIdx = isLowCut ? LowCutFreq : HiCutFreq;
+            auto withCut = [&cs, isLowCut](float freq, int slope) {
+                auto candidate = cs;
+                (isLowCut ? candidate.lowCutFreq : candidate.hiCutFreq) = freq;
+                (isLowCut ? candidate.lowCutSlope : candidate.hiCutSlope) = slope;
+                return candidate;
+            };
+
+            // Off first: a cut has to earn its place
+            auto best = withCut(ParamTable[freqIdx].dflt, 0);
+            double bestError = GetShapeError(target, others, GetCutDb(best, isLowCut));
+            for (float freq : MakeFreqCandidates(freqIdx)) {
+                for (int slope = 0; slope < ParamRanges::numSlopes; slope++) {
+                    const auto candidate = withCut(freq, slope);
+                    const double error = GetShapeError(target, others, GetCutDb(candidate, isLowCut));
+                    if (error < bestError) {
+                        bestError = error;
+                        best = candidate;
+                    }
+                }
+            }
+            cs = best;
+        }
+
+        void SearchPeak(ChainSettings& cs) const
+        {
+            const auto others = Add(GetCutDb(cs, true), GetCutDb(cs, false));
+            const auto& qDesc = ParamTable[PeakQuality];
+            const auto& gainDesc = ParamTable[PeakGain];
+            constexpr int numQs = 17; // 8 per decade over 0.1-10
+
+            auto best = cs;
+            double bestError = GetShapeError(target, others, GetPeakDb(cs));
+            for (float freq : MakeFreqCandidates(PeakFreq)) {
+                for (int q = 0; q < numQs; q++) {
+                    const float quality = Snap(PeakQuality, qDesc.minVal * std::pow(qDesc.maxVal / qDesc.minVal, (float) q / (numQs - 1)));
+                    for (float gain = gainDesc.minVal; gain <= gainDesc.maxVal; gain += gainDesc.interval) {
+                        cs.peakFreq = freq;
+                        cs.peakQ = quality;
+                        cs.peakGaindB = gain;
+                        const double error = GetShapeError(target, others, GetPeakDb(cs));
+                        if (error < bestError) {
+                            bestError = error;
+                            best = cs;
+                        }
+                    }
+                }
+            }
+            cs = best;
+        }
+
+        /*! \brief Coordinate descent, one param interval (1/48 octave for freqs) at a time, until nothing improves */
+        void Refine(ChainSettings& cs) const
+        {
+            const float freqStep = std::pow(2.f, 1.f / 48.f);
+            double bestError = GetError(cs);
+
+            for (int iteration = 0; iteration < 500; iteration++) {
+                bool improved = false;
+                for (int param = 0; param < 5; param++) {
+                    for (float direction : { -1.f, 1.f }) {
+                        auto candidate = cs;
+                        switch (param) {
+                        case 0: candidate.peakFreq = Snap(PeakFreq, cs.peakFreq * std::pow(freqStep, direction)); break;
+                        case 1: candidate.peakQ = Snap(PeakQuality, cs.peakQ + direction * ParamTable[PeakQuality].interval); break;
+                        case 2: candidate.peakGaindB = Snap(PeakGain, cs.peakGaindB + direction * ParamTable[PeakGain].interval); break;
+                        case 3:
+                            if (IsCutOff(cs, true)) continue; // Moving it would turn it on, the search decided against it
+                            candidate.lowCutFreq = Snap(LowCutFreq, cs.lowCutFreq * std::pow(freqStep, direction));
+                            break;
+                        default:
+                            if (IsCutOff(cs, false)) continue;
+                            candidate.hiCutFreq = Snap(HiCutFreq, cs.hiCutFreq * std::pow(freqStep, direction));
+                            break;
+                        }
+
+                        const double error = GetError(candidate);
+                        if (error < bestError - 1e-9) {
+                            bestError = error;
+                            cs = candidate;
+                            improved = true;
+                        }
+                    }
+                }
+                if (!improved) break;
+            }
+        }
+    };
+}
+
+
+// Class functions
+//==============================================================================
+
+double LongTermSpectrum::getSmoothedLevelDb(double freq, double halfBandOctaves) const
+{
+    const int lastBin = (int) power.size() - 1;
+    const double binWidth = sampleRate / (2.0 * lastBin);
+    const int first = juce::jmax(1, (int) std::ceil(freq * std::pow(2.0, -halfBandOctaves) / binWidth));
+    const int last = juce::jmin(lastBin, (int) std::floor(freq * std::pow(2.0, halfBandOctaves) / binWidth));
+
+    double level = 0.0;
+    if (first <= last) {
+        for (int bin = first; bin <= last; bin++) level += power[(size_t) bin];
+        level /= (double) (last - first + 1);
+    } else {
+        // Narrower than a bin (low freqs)
+        const double pos = juce::jlimit(0.0, (double) lastBin, freq / binWidth);
+        const int below = juce::jmin((int) pos, lastBin - 1);
+        level = juce::jmap(pos - below, power[(size_t) below], power[(size_t) below + 1]);
+    }
+    return 10.0 * std::log10(juce::jmax(level, 1e-30));
+}
+
+
+// Free functions
+
+juce::Result AnalyseLongTermSpectrum(const juce::File& file, juce::ThreadPool& pool, LongTermSpectrum& result)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    juce::MemoryMappedAudioFormatReader* mappedReader = nullptr;
+    if (auto* format = formats.findFormatForFileExtension(file.getFileExtension())) {
+        mappedReader = format->createMemoryMappedReader(file); // nullptr for formats that can't be mapped
+        reader.reset(mappedReader);
+    }
+    if (reader == nullptr) {
+        reader.reset(formats.createReaderFor(file));
+    }
+    if (reader == nullptr) {
+        return juce::Result::fail("Can't read " + file.getFullPathName());
+    }
+
+    const int numChannels = juce::jlimit(1, MaxChannels, (int) reader->numChannels);
+    const juce::int64 length = reader->lengthInSamples;
+    const juce::int64 totalFrames = length > FftSize ? 1 + (length - FftSize) / HopSize : 1; // Short files: one padded frame
+
+    // NOTE: Round robin over the jobs. A job's chunk is refilled once its previous one is done, so at most one chunk
+    // per job is in memory, plus the mapped window
+    std::vector<std::unique_ptr<SpectrumJob>> jobs;
+    for (int i = 0; i < juce::jmax(1, pool.getNumThreads()); i++) {
+        jobs.push_back(std::make_unique<SpectrumJob>(numChannels));
+    }
+
+    juce::Range<juce::int64> mappedRange;
+    bool readFailed = false;
+    for (juce::int64 frame = 0, chunkIdx = 0; frame < totalFrames && !readFailed; frame += MatchEqConfig::FramesPerJob, chunkIdx++) {
+        auto& job = *jobs[(size_t) (chunkIdx % (juce::int64) jobs.size())];
+        pool.waitForJobToFinish(&job, -1);
+
+        job.numChunkFrames = (int) juce::jmin((juce::int64) MatchEqConfig::FramesPerJob, totalFrames - frame);
+        const juce::int64 start = frame * HopSize;
+        const int numSamples = (int) juce::jmin((juce::int64) ((job.numChunkFrames - 1) * HopSize + FftSize), length - start);
+        job.chunk.clear();
+
+        if (mappedReader != nullptr && !mappedRange.contains(juce::Range<juce::int64>(start, start + numSamples))) {
+            // Slides over the file: the previous window is unmapped
+            mappedRange = { start, juce::jmin(length, start + juce::jmax(MatchEqConfig::MapWindowSamples, (juce::int64) numSamples)) };
+            readFailed = !mappedReader->mapSectionOfFile(mappedRange);
+        }
+        readFailed = readFailed || !reader->read(job.chunk.getArrayOfWritePointers(), numChannels, start, numSamples);
+        if (!readFailed) {
+            pool.addJob(&job, false);
+        }
+    }
+    for (auto& job : jobs) {
+        pool.waitForJobToFinish(job.get(), -1);
+    }
+    if (readFailed) {
+        return juce::Result::fail("Read error in " + file.getFullPathName());
+    }
+
+    result.sampleRate = reader->sampleRate;
+    result.power.assign((size_t) FftSize / 2 + 1, 0.0);
+    result.numFrames = 0;
+    for (const auto& job : jobs) {
+        for (size_t bin = 0; bin < result.power.size(); bin++) result.power[bin] += job->power[bin];
+        result.numFrames += job->numFrames;
+    }
+    for (auto& p : result.power) p /= (double) juce::jmax((juce::int64) 1, result.numFrames);
+    return juce::Result::ok();
+}
+
+MatchEqFit FitMatchEq(const LongTermSpectrum& stem, const LongTermSpectrum& reference)
+{
+    jassert(stem.isValid() && reference.isValid());
+    const double halfBand = 0.5 / MatchEqConfig::FitPointsPerOctave;
+    const double maxFreq = juce::jmin(16000.0, 0.45 * juce::jmin(stem.sampleRate, reference.sampleRate));
+
+    // Loudest smoothed level of each spectrum, the silence floor is relative to it
+    std::vector<double> pointFreqs, stemDb, referenceDb;
+    for (double f = 25.0; f <= maxFreq; f *= std::pow(2.0, 1.0 / MatchEqConfig::FitPointsPerOctave)) {
+        pointFreqs.push_back(f);
+        stemDb.push_back(stem.getSmoothedLevelDb(f, halfBand));
+        referenceDb.push_back(reference.getSmoothedLevelDb(f, halfBand));
+    }
+    const double stemFloor = *std::max_element(stemDb.begin(), stemDb.end()) - MatchEqConfig::SilenceBelowMaxDb;
+    const double referenceFloor = *std::max_element(referenceDb.begin(), referenceDb.end()) - MatchEqConfig::SilenceBelowMaxDb;
+
+    std::vector<double> fitFreqs;
+    Curve target;
+    for (size_t i = 0; i < pointFreqs.size(); i++) {
+        const double difference = referenceDb[i] - stemDb[i];
+        if (stemDb[i] < stemFloor || referenceDb[i] < referenceFloor || difference < MatchEqConfig::FitFloorDb) continue;
+
+        fitFreqs.push_back(pointFreqs[i]);
+        target.push_back(juce::jmin(difference, MatchEqConfig::MaxBoostDb));
+    }
+
+    // The preset is measured at the stem's rate, the one it is meant to be played at
+    return MatchFitter(std::move(fitFreqs), std::move(target), stem.sampleRate).fit();
+}
+
+juce::Result RunMatchEq(const juce::File& stem, const juce::File& reference, const juce::File& presetFile)
+{
+    juce::ThreadPool pool(juce::SystemStats::getNumCpus());
+
+    LongTermSpectrum stemSpectrum, referenceSpectrum;
+    for (auto [file, spectrum] : { std::pair(&stem, &stemSpectrum), std::pair(&reference, &referenceSpectrum) }) {
+        const auto analysis = AnalyseLongTermSpectrum(*file, pool, *spectrum);
+        if (analysis.failed()) return analysis;
+    }
+
+    const auto fit = FitMatchEq(stemSpectrum, referenceSpectrum);
+    const auto state = MakeStateFromSettings(fit.settings);
+    if (!presetFile.replaceWithData(state.getData(), state.getSize())) {
+        return juce::Result::fail("Can't write " + presetFile.getFullPathName());
+    }
+
+    const auto& cs = fit.settings;
+    juce::Logger::writeToLog("match EQ: low cut " + juce::String(cs.lowCutFreq, 0) + " Hz " + SlopeChoices[cs.lowCutSlope]
+                             + ", peak " + juce::String(cs.peakFreq, 0) + " Hz " + juce::String(cs.peakGaindB, 1) + " dB Q "
+                             + juce::String(cs.peakQ, 2) + ", high cut " + juce::String(cs.hiCutFreq, 0) + " Hz "
+                             + SlopeChoices[cs.hiCutSlope] + " | rms error " + juce::String(fit.rmsErrorDb, 2) + " dB over "
+                             + juce::String(fit.numPoints) + " points, level offset " + juce::String(fit.levelOffsetDb, 1) + " dB");
+    return juce::Result::ok();
+}
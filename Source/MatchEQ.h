@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    Match EQ: settings that make a stem sound like a reference.
+
+    Both files are analysed offline into long-term averaged spectra (Hann
+    windowed FFT frames, half overlapping, power averaged over every frame
+    and channel). Files of any length are streamed: WAV and AIFF through a
+    memory mapped reader, one window of the file mapped at a time, other
+    formats through their plain reader. Chunks of frames go to a thread
+    pool, one FFT and one accumulator per job, and only as many chunks as
+    jobs are ever in memory.
+
+    The difference (reference over stem, 1/6 octave smoothed) is then fitted
+    with the MonoChain: low cut, peak and high cut, within ParamTable's
+    ranges (the ones createParamLayout uses) and snapped like the params.
+    Every candidate is designed by ConfigureMonoChain and measured like the
+    editor's curve, at the stem's sample rate: the fit is what the plugin
+    plays, cut sections and all. The preset uses the Matched design (see
+    MatchedDesign.h), closest to the analog curves at any rate. The
+    broadband level difference is left out: there is no gain param.
+
+    The result is a state in StateFormat, what setStateInformation loads.
+    Runs offline in the Tutorial_EQ_MatchEQ console app (MatchEQ/), never in
+    the plugin: "Tutorial_EQ_MatchEQ <stem> <reference> <preset>".
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+
+namespace MatchEqConfig {
+    constexpr int FftOrder = 13;                      // 8192 points, 5.4Hz bins at 44.1kHz
+    constexpr int FramesPerJob = 64;                  // ~6s of a 44.1kHz file per chunk
+    constexpr juce::int64 MapWindowSamples = 1 << 22; // Mapped at once, ~95s at 44.1kHz
+
+    constexpr double FitPointsPerOctave = 6.0;    // Also the smoothing: each point averages 1/6 octave
+    constexpr double SearchStepsPerOctave = 12.0; // Freqs tried by the coarse search, refined afterwards
+    constexpr double SilenceBelowMaxDb = 90.0;    // Points that far under a spectrum's loudest are silence
+    constexpr double FitFloorDb = -30.0;          // The stem is that much louder: nothing of the reference to match
+    constexpr double MaxBoostDb = 30.0;
+    constexpr int FitRounds = 3;
+}
+
+/*! \brief Power spectrum averaged over a whole file and all its channels */
+struct LongTermSpectrum {
+    double sampleRate { 0.0 };
+    std::vector<double> power; // Mean power per FFT bin, DC to Nyquist
+    juce::int64 numFrames { 0 }; // Frames averaged, every channel counted
+
+    bool isValid() const { return numFrames > 0; }
+    /*! \brief Mean power of the bins within halfBandOctaves of freq, in dB. Interpolated between bins when none is */
+    double getSmoothedLevelDb(double freq, double halfBandOctaves) const;
+};
+
+/*! \brief Streams the file, see MatchEQ.h. Memory doesn't grow with the file's length */
+juce::Result AnalyseLongTermSpectrum(const juce::File& file, juce::ThreadPool& pool, LongTermSpectrum& result);
+
+struct MatchEqFit {
+    ChainSettings settings;
+    double rmsErrorDb { 0.0 };    // Fitted curve vs difference, over the fitted points, level offset removed
+    double levelOffsetDb { 0.0 }; // Reference minus EQed stem, broadband. Not part of the preset
+    int numPoints { 0 };
+};
+
+/*! \brief The MonoChain settings whose curve best follows reference / stem. Neutral if no point could be fitted */
+MatchEqFit FitMatchEq(const LongTermSpectrum& stem, const LongTermSpectrum& reference);
+
+/*! \brief Analyses both files, fits, writes the fitted settings as a state to presetFile and logs the fit */
+juce::Result RunMatchEq(const juce::File& stem, const juce::File& reference, const juce::File& presetFile);
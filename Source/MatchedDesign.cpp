@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    Matched designs, see MatchedDesign.h
+
+  ==============================================================================
+*/
+
+#include "MatchedDesign.h"
+
+namespace {
+    /*! \brief Squared magnitude of a biquad over the phi basis: sum of X[i] phi[i] for the numerator (B) or the
+        denominator (A), with phi0 = cos^2(w/2), phi1 = sin^2(w/2), phi2 = 4 phi0 phi1 */
+    struct MatchBasis {
+        double phi0, phi1, phi2;
+
+        explicit MatchBasis(double w)
+        {
+            phi1 = std::pow(std::sin(0.5 * w), 2.0);
+            phi0 = 1.0 - phi1;
+            phi2 = 4.0 * phi0 * phi1;
+        }
+    };
+
+    /*! \brief Impulse invariant poles of s^2 + 2 zeta s + 1 at w0 (rad/sample). Damping over 1 means real poles */
+    void SetMatchedPoles(double w0, double zeta, double& a1, double& a2)
+    {
+        const double r = std::exp(-zeta * w0);
+        a1 = zeta <= 1.0 ? -2.0 * r * std::cos(w0 * std::sqrt(1.0 - zeta * zeta))
+                         : -2.0 * r * std::cosh(w0 * std::sqrt(zeta * zeta - 1.0));
+        a2 = r * r;
+    }
+
+    struct Biquad {
+        double b0 { 1.0 }, b1 { 0.0 }, b2 { 0.0 }, a1 { 0.0 }, a2 { 0.0 };
+
+        BiquadCoefs toFloat() const { return { (float) b0, (float) b1, (float) b2, (float) a1, (float) a2 }; }
+    };
+
+    /*! \brief A0, A1, A2 of the denominator, and its squared magnitude at w */
+    struct PoleTerms {
+        double A0, A1, A2;
+
+        explicit PoleTerms(const Biquad& c)
+            : A0(std::pow(1.0 + c.a1 + c.a2, 2.0)), A1(std::pow(1.0 - c.a1 + c.a2, 2.0)), A2(-4.0 * c.a2) {}
+
+        double at(const MatchBasis& p) const { return A0 * p.phi0 + A1 * p.phi1 + A2 * p.phi2; }
+    };
+
+    Biquad MakeBoost(double sampleRate, double freq, double q, double gainFactor)
+    {
+        const double A = std::sqrt(gainFactor);
+        const double w0 = juce::MathConstants<double>::twoPi * freq / sampleRate;
+
+        Biquad c;
+        SetMatchedPoles(w0, 1.0 / (2.0 * q * A), c.a1, c.a2); // Denominator s^2 + s/(A Q) + 1
+        const PoleTerms poles(c);
+        const MatchBasis centre(w0);
+
+        // Matched at DC (1), the centre (gainFactor) and Nyquist (the analog curve there)
+        const double nyquistMag = GetAnalogPeakMagnitude(0.5 * sampleRate, freq, q, gainFactor);
+        const double B0 = poles.A0;
+        const double B1 = poles.A1 * nyquistMag * nyquistMag;
+        const double B2 = (gainFactor * gainFactor * poles.at(centre) - B0 * centre.phi0 - B1 * centre.phi1) / centre.phi2;
+
+        // Back to coefficients, zeros inside the unit circle
+        const double sqrtB0 = std::sqrt(B0), sqrtB1 = std::sqrt(B1);
+        const double W = 0.5 * (sqrtB0 + sqrtB1);
+        c.b0 = 0.5 * (W + std::sqrt(juce::jmax(0.0, W * W + B2)));
+        c.b1 = 0.5 * (sqrtB0 - sqrtB1);
+        c.b2 = -B2 / (4.0 * c.b0);
+        return c;
+    }
+}
+
+
+// Free functions
+
+BiquadCoefs MakeMatchedPeakCoefs(double sampleRate, double freq, double q, double gainFactor)
+{
+    if (gainFactor >= 1.0) {
+        return MakeBoost(sampleRate, freq, q, gainFactor).toFloat();
+    }
+
+    // The cut is the boost by 1 / gainFactor, upside down
+    const auto boost = MakeBoost(sampleRate, freq, q, 1.0 / gainFactor);
+    Biquad c;
+    c.b0 = 1.0 / boost.b0;
+    c.b1 = boost.a1 / boost.b0;
+    c.b2 = boost.a2 / boost.b0;
+    c.a1 = boost.b1 / boost.b0;
+    c.a2 = boost.b2 / boost.b0;
+    return c.toFloat();
+}
+
+BiquadCoefs MakeMatchedLowPassCoefs(double sampleRate, double freq, double q)
+{
+    const double w0 = juce::MathConstants<double>::twoPi * freq / sampleRate;
+
+    Biquad c;
+    SetMatchedPoles(w0, 1.0 / (2.0 * q), c.a1, c.a2);
+    const PoleTerms poles(c);
+    const MatchBasis corner(w0);
+
+    // Matched at DC (1) and the corner (Q), with a single zero (b2 = 0)
+    const double B0 = poles.A0;
+    const double B1 = juce::jmax(0.0, (poles.at(corner) * q * q - B0 * corner.phi0) / corner.phi1);
+    c.b0 = 0.5 * (std::sqrt(B0) + std::sqrt(B1));
+    c.b1 = std::sqrt(B0) - c.b0;
+    return c.toFloat();
+}
+
+BiquadCoefs MakeMatchedHighPassCoefs(double sampleRate, double freq, double q)
+{
+    const double w0 = juce::MathConstants<double>::twoPi * freq / sampleRate;
+
+    Biquad c;
+    SetMatchedPoles(w0, 1.0 / (2.0 * q), c.a1, c.a2);
+    const PoleTerms poles(c);
+    const MatchBasis corner(w0);
+
+    // Double zero at DC, so only the gain is left: matched at the corner (Q)
+    c.b0 = q * std::sqrt(poles.at(corner)) / (4.0 * corner.phi1);
+    c.b1 = -2.0 * c.b0;
+    c.b2 = c.b0;
+    return c.toFloat();
+}
+
+juce::dsp::IIR::Coefficients<float>::Ptr MakeMatchedPeakFilter(double sampleRate, float freq, float q, float gainFactor)
+{
+    const auto c = MakeMatchedPeakCoefs(sampleRate, freq, q, gainFactor);
+    return new juce::dsp::IIR::Coefficients<float>(c.b0, c.b1, c.b2, 1.f, c.a1, c.a2);
+}
+
+juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>> DesignMatchedButterworth(float freq, double sampleRate,
+                                                                                           int order, bool isHighPass)
+{
+    jassert(order > 0 && order % 2 == 0);
+    juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>> sections;
+
+    // NOTE: Same Q for each section, in the same order, as designIIR*HighOrderButterworthMethod
+    for (int i = 0; i < order / 2; i++) {
+        const double q = 1.0 / (2.0 * std::cos((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+        const auto c = isHighPass ? MakeMatchedHighPassCoefs(sampleRate, freq, q) : MakeMatchedLowPassCoefs(sampleRate, freq, q);
+        sections.add(new juce::dsp::IIR::Coefficients<float>(c.b0, c.b1, c.b2, 1.f, c.a1, c.a2));
+    }
+    return sections;
+}
+
+double GetAnalogPeakMagnitude(double freq, double centreFreq, double q, double gainFactor)
+{
+    // (s^2 + s A/Q + 1) / (s^2 + s/(A Q) + 1), at s = j freq/centreFreq
+    const double A = std::sqrt(gainFactor);
+    const double w = freq / centreFreq;
+    const double re = 1.0 - w * w;
+    const double num = re * re + std::pow(A * w / q, 2.0);
+    const double den = re * re + std::pow(w / (A * q), 2.0);
+    return std::sqrt(num / den);
+}
+
+double GetAnalogButterworthMagnitude(double freq, double cornerFreq, int order, bool isHighPass)
+{
+    const double w2n = std::pow(freq / cornerFreq, 2.0 * order);
+    return std::sqrt((isHighPass ? w2n : 1.0) / (1.0 + w2n));
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    Matched designs: biquads that track the analog prototype up to Nyquist.
+
+    The bilinear transform (RBJ's peak, JUCE's Butterworth cuts) maps the
+    whole analog axis into 0..Nyquist. The top of the spectrum gets
+    squeezed: bells narrow and lean toward low freqs, and cuts get an
+    infinitely deep notch at Nyquist. Oversampling pushes the cramping out
+    of the audio band, at 2 to 4 times the CPU.
+
+    These designs follow Vicanek ("Matched Second Order Digital Filters",
+    2016):
+    - The poles are the analog ones, mapped by impulse invariance
+      (z = e^(sT)), so they sit where the analog resonance is.
+    - The zeros are solved so that the magnitude matches the analog one
+      exactly at a few frequencies. For a bell: DC, the centre and
+      Nyquist. A cut is matched at DC and at its corner.
+    - A cut bell is the inverse of the boost with the same Q (true of
+      the analog prototype). Matching the cut directly gives poor zeros
+      when its poles are very damped.
+
+    Worst deviation from the analog curve, 20Hz-20kHz, over Q 0.3-10 and
+    +-24 dB (peak), or orders 2-8 over the passband and transition down to
+    -24 dB (cuts):
+
+        at 44.1kHz     centre/corner   1k     5k     10k    15k    20k
+        peak, matched      (dB)        0.4    0.9    1.0    1.7    4.0
+        peak, bilinear                 1.6    9.2    11.8   12.7   15.1
+        cuts, matched                  0.0    1.6    2.8    4.1    1.5
+        cuts, bilinear                 0.4    24.6   44.1   70.2   76.6
+
+    At 48kHz, every figure is a bit lower. The remaining error of the
+    matched bells sits on the skirts of wide bells (low Q). The matched
+    low pass has a single zero, so its stop band near Nyquist stays above
+    the analog one. DesignTest checks these bounds, with a bit of room for
+    the float coefficients.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadKernels.h"
+
+
+/*! \brief Bell at freq, RBJ's analog prototype (same Q and gain meaning as makePeakFilter). gainFactor is linear */
+BiquadCoefs MakeMatchedPeakCoefs(double sampleRate, double freq, double q, double gainFactor);
+/*! \brief 2nd order sections, 1 / (s^2 + s/Q + 1) and s^2 / (s^2 + s/Q + 1) at freq */
+BiquadCoefs MakeMatchedLowPassCoefs(double sampleRate, double freq, double q);
+BiquadCoefs MakeMatchedHighPassCoefs(double sampleRate, double freq, double q);
+
+/*! \brief Drop-in replacements for IIR::Coefficients::makePeakFilter and FilterDesign's high order Butterworth
+    methods: same sections, in the same order. order must be even */
+juce::dsp::IIR::Coefficients<float>::Ptr MakeMatchedPeakFilter(double sampleRate, float freq, float q, float gainFactor);
+juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>> DesignMatchedButterworth(float freq, double sampleRate,
+                                                                                           int order, bool isHighPass);
+
+/*! \brief The analog curves the designs are matched to, as linear magnitudes */
+double GetAnalogPeakMagnitude(double freq, double centreFreq, double q, double gainFactor);
+double GetAnalogButterworthMagnitude(double freq, double cornerFreq, int order, bool isHighPass);
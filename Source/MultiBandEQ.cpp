@@ -0,0 +1,273 @@
+/*
+  ==============================================================================
+
+    N-band parametric EQ engine.
+
+  ==============================================================================
+*/
+
+#include "MultiBandEQ.h"
+
+
+// Free functions
+
+BiquadCoefs MakeBandCoefs(const BandSettings& band, double sampleRate)
+{
+    // Keep the center freq under Nyquist, otherwise the design blows up
+    const double freq = juce::jlimit(1.0, sampleRate * 0.499, (double) band.freq);
+    const double w0 = juce::MathConstants<double>::twoPi * freq / sampleRate;
+    const double cosW0 = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * juce::jmax(0.01, (double) band.q));
+    const double A = std::pow(10.0, band.gaindB / 40.0); // sqrt of the linear gain
+    const double sqrtA2alpha = 2.0 * std::sqrt(A) * alpha;
+
+    double nb0, nb1, nb2, na0, na1, na2;
+
+    switch (band.type) {
+    case BandType::LowShelf:
+        nb0 = A * ((A + 1) - (A - 1) * cosW0 + sqrtA2alpha);
+        nb1 = 2 * A * ((A - 1) - (A + 1) * cosW0);
+        nb2 = A * ((A + 1) - (A - 1) * cosW0 - sqrtA2alpha);
+        na0 = (A + 1) + (A - 1) * cosW0 + sqrtA2alpha;
+        na1 = -2 * ((A - 1) + (A + 1) * cosW0);
+        na2 = (A + 1) + (A - 1) * cosW0 - sqrtA2alpha;
+        break;
+    case BandType::HighShelf:
+        nb0 = A * ((A + 1) + (A - 1) * cosW0 + sqrtA2alpha);
+        nb1 = -2 * A * ((A - 1) + (A + 1) * cosW0);
+        nb2 = A * ((A + 1) + (A - 1) * cosW0 - sqrtA2alpha);
+        na0 = (A + 1) - (A - 1) * cosW0 + sqrtA2alpha;
+        na1 = 2 * ((A - 1) - (A + 1) * cosW0);
+        na2 = (A + 1) - (A - 1) * cosW0 - sqrtA2alpha;
+        break;
+    case BandType::Notch:
+        nb0 = 1;
+        nb1 = -2 * cosW0;
+        nb2 = 1;
+        na0 = 1 + alpha;
+        na1 = -2 * cosW0;
+        na2 = 1 - alpha;
+        break;
+    case BandType::Bell:
+    default:
+        nb0 = 1 + alpha * A;
+        nb1 = -2 * cosW0;
+        nb2 = 1 - alpha * A;
+        na0 = 1 + alpha / A;
+        na1 = -2 * cosW0;
+        na2 = 1 - alpha / A;
+        break;
+    }
+
+    // Normalize so a0 is 1, the processing loop never divides
+    BiquadCoefs c;
+    c.b0 = (float) (nb0 / na0);
+    c.b1 = (float) (nb1 / na0);
+    c.b2 = (float) (nb2 / na0);
+    c.a1 = (float) (na1 / na0);
+    c.a2 = (float) (na2 / na0);
+    return c;
+}
+
+bool IsBandIdentity(const BandSettings& band, float thresholdDb)
+{
+    if (!band.active) return true;
+    // A notch always removes something, the other types are flat at 0 dB
+    return band.type != BandType::Notch && std::abs(band.gaindB) <= thresholdDb;
+}
+
+double GetBandMagnitudeForFrequency(const BandSettings& band, double freq, double sampleRate)
+{
+    if (!band.active) return 1.0;
+
+    const auto c = MakeBandCoefs(band, sampleRate);
+    const double w = juce::MathConstants<double>::twoPi * freq / sampleRate;
+    const std::complex<double> z1 = std::polar(1.0, -w); // z^-1
+    const auto num = (double) c.b0 + z1 * ((double) c.b1 + z1 * (double) c.b2);
+    const auto den = 1.0 + z1 * ((double) c.a1 + z1 * (double) c.a2);
+    return std::abs(num / den);
+}
+
+void CrossfadeFromDry(float* wet, const float* dry, int numSamples, bool fadeIn)
+{
+    if (numSamples <= 0) return;
+
+    const float step = 1.f / (float) numSamples;
+    for (int n = 0; n < numSamples; n++) {
+        const float g = fadeIn ? (n + 1) * step : 1.f - (n + 1) * step; // Weight of the wet signal
+        wet[n] = dry[n] + (wet[n] - dry[n]) * g;
+    }
+}
+
+double GetBiquadPoleRadius(double a1, double a2)
+{
+    const double disc = a1 * a1 - 4.0 * a2;
+    if (disc < 0.0) {
+        return std::sqrt(a2); // Complex conjugate poles, |p|^2 == a2
+    }
+    const double sqrtDisc = std::sqrt(disc);
+    return juce::jmax(std::abs(-a1 + sqrtDisc), std::abs(-a1 - sqrtDisc)) * 0.5;
+}
+
+int GetDecaySamples(double poleRadius, double floorGain)
+{
+    if (poleRadius >= 1.0) return MaxDecaySamples;
+    if (poleRadius <= 0.0) return 2; // No feedback, only the 2 sample FIR part
+
+    // r^n == floorGain
+    const double n = std::ceil(std::log(floorGain) / std::log(poleRadius)) + 2.0;
+    return (int) juce::jmin((double) MaxDecaySamples, n);
+}
+
+
+// Class functions
+//==============================================================================
+void MultiBandEQ::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels <= (juce::uint32) MaxChannels);
+    sampleRate = spec.sampleRate;
+    numChannels = juce::jmin((int) spec.numChannels, MaxChannels);
+    fadeScratch.assign(spec.maximumBlockSize, 0.f);
+
+    // Once here, not per block: the CPU won't change, and the override is for testing
+    kernelIsa = SelectKernelIsa();
+    cascadeKernel = GetCascadeKernel(kernelIsa);
+
+    // The designs depend on the sample rate
+    for (int i = 0; i < MaxBands; i++) {
+        setBand(i, settings[i]);
+        isFading[i] = false; // Nothing is playing yet
+    }
+    rebuildActiveList();
+    reset();
+}
+
+void MultiBandEQ::reset()
+{
+    for (auto& chan : s1) chan.fill(0.f);
+    for (auto& chan : s2) chan.fill(0.f);
+}
+
+void MultiBandEQ::setBand(int bandIdx, const BandSettings& band)
+{
+    jassert(juce::isPositiveAndBelow(bandIdx, MaxBands));
+
+    settings[bandIdx] = band;
+
+    const auto c = MakeBandCoefs(band, sampleRate);
+    b0[bandIdx] = c.b0;
+    b1[bandIdx] = c.b1;
+    b2[bandIdx] = c.b2;
+    a1[bandIdx] = c.a1;
+    a2[bandIdx] = c.a2;
+
+    updateNeutral(bandIdx);
+    rebuildActiveList();
+}
+
+void MultiBandEQ::setNeutralThreshold(float thresholdDb)
+{
+    if (thresholdDb == neutralThresholdDb) return; // Called on every redesign
+    neutralThresholdDb = thresholdDb;
+
+    for (int i = 0; i < MaxBands; i++) {
+        updateNeutral(i);
+    }
+    rebuildActiveList();
+}
+
+void MultiBandEQ::updateNeutral(int bandIdx)
+{
+    const bool neutral = IsBandIdentity(settings[bandIdx], neutralThresholdDb);
+    if (neutral != isNeutral[bandIdx]) {
+        // A band coming back into the cascade must not reuse stale states, it fades in from them cleared
+        if (!neutral) {
+            for (int ch = 0; ch < MaxChannels; ch++) {
+                s1[ch][bandIdx] = 0.f;
+                s2[ch][bandIdx] = 0.f;
+            }
+        }
+        isNeutral[bandIdx] = neutral;
+        isFading[bandIdx] = true;
+    }
+}
+
+void MultiBandEQ::rebuildActiveList()
+{
+    numActive = 0;
+    for (int i = 0; i < MaxBands; i++) {
+        if (!isNeutral[i] || isFading[i]) {
+            cascadeCoefs[numActive] = { b0[i], b1[i], b2[i], a1[i], a2[i] };
+            activeIdx[numActive++] = i;
+        }
+    }
+}
+
+void MultiBandEQ::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (numActive == 0 || context.isBypassed) return; // Nothing to do, costs nothing
+
+    auto& block = context.getOutputBlock();
+    const int numSamples = (int) block.getNumSamples();
+    const int chans = juce::jmin((int) block.getNumChannels(), numChannels);
+    const bool canFade = numSamples <= (int) fadeScratch.size(); // Otherwise bands switch instantly
+
+    bool anyFading = false;
+    for (int k = 0; k < numActive; k++) {
+        anyFading = anyFading || isFading[activeIdx[k]];
+    }
+
+    for (int ch = 0; ch < chans; ch++) {
+        float* data = block.getChannelPointer((size_t) ch);
+
+        if (!anyFading || !canFade) {
+            // The whole cascade in one call, with the kernel picked for this CPU
+            std::array<float, MaxBands> z1, z2;
+            for (int k = 0; k < numActive; k++) {
+                z1[k] = s1[ch][activeIdx[k]];
+                z2[k] = s2[ch][activeIdx[k]];
+            }
+            cascadeKernel(data, numSamples, cascadeCoefs.data(), z1.data(), z2.data(), numActive);
+            for (int k = 0; k < numActive; k++) {
+                s1[ch][activeIdx[k]] = z1[k];
+                s2[ch][activeIdx[k]] = z2[k];
+            }
+            continue;
+        }
+
+        // A band enters or leaves the path: band by band, so it can be crossfaded with its own input
+        for (int k = 0; k < numActive; k++) {
+            const int i = activeIdx[k];
+            if (isFading[i]) {
+                juce::FloatVectorOperations::copy(fadeScratch.data(), data, numSamples);
+            }
+
+            ProcessCascadeScalar(data, numSamples, &cascadeCoefs[k], &s1[ch][i], &s2[ch][i], 1);
+
+            if (isFading[i]) {
+                CrossfadeFromDry(data, fadeScratch.data(), numSamples, !isNeutral[i]);
+            }
+        }
+    }
+
+    // Fades last one block. Bands that faded out leave the cascade
+    bool anyFaded = false;
+    for (int k = 0; k < numActive; k++) {
+        const int i = activeIdx[k];
+        if (isFading[i]) {
+            isFading[i] = false;
+            anyFaded = true;
+        }
+    }
+    if (anyFaded) rebuildActiveList();
+}
+
+int MultiBandEQ::getTailSamples(double floorGain) const
+{
+    juce::int64 total = 0;
+    for (int k = 0; k < numActive; k++) {
+        const int i = activeIdx[k];
+        total += GetDecaySamples(GetBiquadPoleRadius(a1[i], a2[i]), floorGain);
+    }
+    return (int) juce::jmin((juce::int64) MaxDecaySamples, total);
+}
@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    N-band parametric EQ engine.
+
+    Unlike MonoChain (one ProcessorChain element per band), every band's
+    coefficients and states live in flat arrays (structure of arrays), and only
+    the bands that are active are visited when processing. So the CPU cost
+    follows the number of active bands, not MaxBands.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadKernels.h"
+
+
+enum class BandType {
+    Bell,
+    LowShelf,
+    HighShelf,
+    Notch
+};
+
+struct BandSettings {
+    BandType type { BandType::Bell };
+    float freq { 1000.f }, gaindB { 0.f }, q { 1.f };
+    bool active { false };
+
+    bool operator==(const BandSettings& other) const
+    {
+        return type == other.type && freq == other.freq && gaindB == other.gaindB && q == other.q
+            && active == other.active;
+    }
+    bool operator!=(const BandSettings& other) const { return !(*this == other); }
+};
+
+/*! \brief RBJ cookbook designs. Unlike IIR::Coefficients::make*, they don't allocate,
+    so they can be called from the audio thread */
+BiquadCoefs MakeBandCoefs(const BandSettings& band, double sampleRate);
+
+/*! \brief Returns true if the band does (almost) nothing to the signal: not active, or a bell/shelf
+    whose gain is within thresholdDb of 0 dB. Their worst deviation over 20Hz-20kHz is their gain,
+    reached at the centre (bell) or on the shelf */
+bool IsBandIdentity(const BandSettings& band, float thresholdDb = 0.f);
+
+/*! \brief Magnitude of the band's biquad at freq, 1 when not active */
+double GetBandMagnitudeForFrequency(const BandSettings& band, double freq, double sampleRate);
+
+/*! \brief Linear crossfade of wet against dry, in place in wet. fadeIn goes from dry to wet, otherwise wet to dry.
+    Used so a band entering or leaving the processing path doesn't click */
+void CrossfadeFromDry(float* wet, const float* dry, int numSamples, bool fadeIn);
+
+/*! \brief Largest pole radius of a normalized biquad, i.e. of z^2 + a1 z + a2 */
+double GetBiquadPoleRadius(double a1, double a2);
+
+/*! \brief Samples needed for a section with that pole radius to decay by floorGain.
+    Unstable or marginal sections (radius >= 1) get MaxDecaySamples */
+int GetDecaySamples(double poleRadius, double floorGain);
+constexpr int MaxDecaySamples = 1 << 20; // ~22s at 48kHz
+
+
+class MultiBandEQ
+{
+public:
+    static constexpr int MaxBands = 24;
+    static constexpr int MaxChannels = 2;
+
+    /*! \note Same interface as the juce::dsp processors, so it could go in a ProcessorChain */
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+    /*! \brief Redesigns a single band. Does not allocate, safe to call from the audio thread */
+    void setBand(int bandIdx, const BandSettings& band);
+    const BandSettings& getBand(int bandIdx) const { return settings[bandIdx]; }
+    const std::array<BandSettings, MaxBands>& getBands() const { return settings; }
+
+    int getNumActiveBands() const { return numActive; }
+
+    /*! \brief Bands deviating less than that from flat are skipped. Every band is re-classified at once, those
+        that change side fade in or out like with setBand. Does not allocate, safe to call from the audio thread */
+    void setNeutralThreshold(float thresholdDb);
+
+    /*! \brief Samples for the active cascade to decay by floorGain (sum of each band's decay) */
+    int getTailSamples(double floorGain) const;
+
+    /*! \brief Instruction set of the cascade kernel, picked in prepare */
+    KernelIsa getKernelIsa() const { return kernelIsa; }
+
+private:
+    /*! \brief Keeps activeIdx sorted by band index, so the cascade order doesn't depend on edit order */
+    void rebuildActiveList();
+    /*! \brief Classifies the band against neutralThresholdDb, starting its fade if it changed side */
+    void updateNeutral(int bandIdx);
+
+    double sampleRate { 44100.0 };
+    int numChannels { MaxChannels };
+
+    std::array<BandSettings, MaxBands> settings;
+
+    // Structure of arrays: one contiguous array per coefficient, and per state for each channel
+    alignas(16) std::array<float, MaxBands> b0 {}, b1 {}, b2 {}, a1 {}, a2 {};
+    alignas(16) std::array<std::array<float, MaxBands>, MaxChannels> s1 {}, s2 {};
+
+    // Bands in the processing path: not neutral, or fading in or out of it
+    std::array<int, MaxBands> activeIdx {};
+    int numActive { 0 };
+    std::array<BiquadCoefs, MaxBands> cascadeCoefs {}; // Coefs of activeIdx, in the same order, for the kernel
+
+    KernelIsa kernelIsa { KernelIsa::Scalar };
+    CascadeKernel cascadeKernel { ProcessCascadeScalar };
+
+    float neutralThresholdDb { 0.f };
+    std::array<bool, MaxBands> isNeutral {}, isFading {};
+    std::vector<float> fadeScratch; // Dry copy while a band fades, sized in prepare
+};
+
+/*! \brief Every band of a MultiBandEQ, e.g. what the linear phase kernel folds in */
+using ExtraBandSettings = std::array<BandSettings, MultiBandEQ::MaxBands>;
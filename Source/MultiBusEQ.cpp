@@ -0,0 +1,344 @@
+/*
+  ==============================================================================
+
+    Multi-bus EQ, see MultiBusEQ.h
+
+  ==============================================================================
+*/
+
+#include "MultiBusEQ.h"
+#include "SharedResources.h"
+#include "BlockIIR.h"
+
+
+// Class functions
+//==============================================================================
+MultiBusEngine::MultiBusEngine()
+{
+    for (int s = 0; s < MultiBus::NumSections; s++) {
+        for (int lane = 0; lane < MultiBus::NumLanes; lane++) {
+            b0[s][lane] = 1.f;
+            b1[s][lane] = b2[s][lane] = a1[s][lane] = a2[s][lane] = 0.f;
+        }
+    }
+    reset();
+}
+
+void MultiBusEngine::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void MultiBusEngine::reset()
+{
+    std::fill(&s1[0][0], &s1[0][0] + MultiBus::NumSections * MultiBus::NumLanes, 0.f);
+    std::fill(&s2[0][0], &s2[0][0] + MultiBus::NumSections * MultiBus::NumLanes, 0.f);
+    std::fill(&parkedS1[0][0], &parkedS1[0][0] + MultiBus::NumSections * MultiBus::NumLanes, 0.f);
+    std::fill(&parkedS2[0][0], &parkedS2[0][0] + MultiBus::NumSections * MultiBus::NumLanes, 0.f);
+}
+
+void MultiBusEngine::setBus(int bus, const ChainSettings& cs)
+{
+    jassert(juce::isPositiveAndBelow(bus, MultiBus::MaxBuses));
+
+    // NOTE: Designed through a MonoChain, so every bus sounds exactly like the single bus processor
+    ConfigureMonoChain(designChain, cs, sampleRate);
+
+    auto setSection = [this, bus](int section, const Filter& filter, bool isOn) {
+        BiquadCoefs c; // Identity
+        if (isOn && filter.coefficients != nullptr) {
+            // IIR::Coefficients layout: b0 b1 b2 a1 a2, or b0 b1 a1 for 1st order
+            const auto& raw = filter.coefficients->coefficients;
+            if (raw.size() >= 5) {
+                c = { raw[0], raw[1], raw[2], raw[3], raw[4] };
+            } else if (raw.size() >= 3) {
+                c = { raw[0], raw[1], 0.f, raw[2], 0.f };
+            }
+        }
+
+        const bool wasOn = isSectionOn[(size_t) bus][(size_t) section];
+        for (int lane = 2 * bus; lane < 2 * bus + 2; lane++) {
+            b0[section][lane] = c.b0;
+            b1[section][lane] = c.b1;
+            b2[section][lane] = c.b2;
+            a1[section][lane] = c.a1;
+            a2[section][lane] = c.a2;
+            // The identity must run on zero states. A MonoChain filter keeps its states while bypassed, so does this
+            if (wasOn && !isOn) {
+                parkedS1[section][lane] = std::exchange(s1[section][lane], 0.f);
+                parkedS2[section][lane] = std::exchange(s2[section][lane], 0.f);
+            } else if (!wasOn && isOn) {
+                s1[section][lane] = parkedS1[section][lane];
+                s2[section][lane] = parkedS2[section][lane];
+            }
+        }
+        isSectionOn[(size_t) bus][(size_t) section] = isOn;
+    };
+
+    busTailSamples[(size_t) bus] = GetChainTailSamples(designChain, MultiBus::TailFloor);
+
+    const auto& lowCut = designChain.get<MonoChainIdx::LowCut>();
+    const auto& hiCut = designChain.get<MonoChainIdx::HiCut>();
+    const int lowCutFirst = GetFirstSection(MonoChainIdx::LowCut);
+    const int hiCutFirst = GetFirstSection(MonoChainIdx::HiCut);
+
+    setSection(lowCutFirst + 0, lowCut.get<0>(), !lowCut.isBypassed<0>());
+    setSection(lowCutFirst + 1, lowCut.get<1>(), !lowCut.isBypassed<1>());
+    setSection(lowCutFirst + 2, lowCut.get<2>(), !lowCut.isBypassed<2>());
+    setSection(lowCutFirst + 3, lowCut.get<3>(), !lowCut.isBypassed<3>());
+    setSection(GetFirstSection(MonoChainIdx::Peak), designChain.get<MonoChainIdx::Peak>(), true);
+    setSection(hiCutFirst + 0, hiCut.get<0>(), !hiCut.isBypassed<0>());
+    setSection(hiCutFirst + 1, hiCut.get<1>(), !hiCut.isBypassed<1>());
+    setSection(hiCutFirst + 2, hiCut.get<2>(), !hiCut.isBypassed<2>());
+    setSection(hiCutFirst + 3, hiCut.get<3>(), !hiCut.isBypassed<3>());
+
+    RebuildActiveSections();
+}
+
+int MultiBusEngine::getTailSamples() const
+{
+    return *std::max_element(busTailSamples.begin(), busTailSamples.end());
+}
+
+void MultiBusEngine::RebuildActiveSections()
+{
+    numActiveSections = 0;
+    for (int s = 0; s < MultiBus::NumSections; s++) {
+        bool isUsed = false;
+        for (const auto& sections : isSectionOn) isUsed = isUsed || sections[(size_t) s];
+        if (isUsed) activeSections[(size_t) numActiveSections++] = s;
+    }
+}
+
+void MultiBusEngine::process(float* const* lanes, int numSamples) noexcept
+{
+    for (int start = 0; start < numSamples; start += MultiBus::FrameLength) {
+        const int n = juce::jmin(MultiBus::FrameLength, numSamples - start);
+
+        // Channels to lanes. Silence in unused lanes keeps their states (and the vector math) clean
+        for (int lane = 0; lane < MultiBus::NumLanes; lane++) {
+            const float* in = lanes[lane];
+            for (int i = 0; i < n; i++) frame[i][lane] = in != nullptr ? in[start + i] : 0.f;
+        }
+
+        ProcessFrame(n);
+
+        for (int lane = 0; lane < MultiBus::NumLanes; lane++) {
+            float* out = lanes[lane];
+            if (out == nullptr) continue;
+            for (int i = 0; i < n; i++) out[start + i] = frame[i][lane];
+        }
+    }
+
+    for (int k = 0; k < numActiveSections; k++) {
+        const int s = activeSections[(size_t) k];
+        for (int lane = 0; lane < MultiBus::NumLanes; lane++) {
+            juce::dsp::util::snapToZero(s1[s][lane]);
+            juce::dsp::util::snapToZero(s2[s][lane]);
+        }
+    }
+}
+
+void MultiBusEngine::ProcessFrame(int numSamples) noexcept
+{
+    // NOTE: Sample by sample through the cascade, like MonoChain, but each step is one TDF-II update of all
+    // the lanes. Member arrays don't alias, so the lane loop is vectorized without runtime checks
+    for (int i = 0; i < numSamples; i++) {
+        for (int k = 0; k < numActiveSections; k++) {
+            const int s = activeSections[(size_t) k];
+            for (int lane = 0; lane < MultiBus::NumLanes; lane++) {
+                const float x = frame[i][lane];
+                const float y = b0[s][lane] * x + s1[s][lane];
+                s1[s][lane] = b1[s][lane] * x - a1[s][lane] * y + s2[s][lane];
+                s2[s][lane] = b2[s][lane] * x - a2[s][lane] * y;
+                frame[i][lane] = y;
+            }
+        }
+    }
+}
+
+
+//==============================================================================
+MultiBusEQAudioProcessor::MultiBusEQAudioProcessor()
+    : AudioProcessor(MakeBusesProperties())
+{
+    engine = std::make_unique<MultiBusEngine>();
+
+    for (int bus = 0; bus < MultiBus::MaxBuses; bus++) {
+        for (int p = 0; p < MultiBus::NumBusParams; p++) {
+            const auto idx = static_cast<ParamIdx>(p);
+            const auto id = GetBusParamId(bus, idx);
+            busParamHandles[(size_t) bus][idx] = apvts.getRawParameterValue(id);
+            busParamObjects[(size_t) bus][(size_t) p] = apvts.getParameter(id);
+            jassert(busParamHandles[(size_t) bus][idx] != nullptr);
+        }
+    }
+
+    const auto* designModeId = ParamTable[DesignMode].id;
+    designModeParam = apvts.getParameter(designModeId);
+    for (auto& handles : busParamHandles) {
+        handles[DesignMode] = apvts.getRawParameterValue(designModeId);
+    }
+}
+
+MultiBusEQAudioProcessor::~MultiBusEQAudioProcessor()
+{
+}
+
+/* static */ juce::AudioProcessor::BusesProperties MultiBusEQAudioProcessor::MakeBusesProperties()
+{
+    // Only the first pair is on by default, the host enables the others as the template needs them
+    BusesProperties props;
+    for (int bus = 0; bus < MultiBus::MaxBuses; bus++) {
+        const auto name = "Bus " + juce::String(bus + 1);
+        props = props.withInput(name, juce::AudioChannelSet::stereo(), bus == 0)
+                     .withOutput(name, juce::AudioChannelSet::stereo(), bus == 0);
+    }
+    return props;
+}
+
+/* static */ juce::String MultiBusEQAudioProcessor::GetBusParamId(int bus, ParamIdx idx)
+{
+    return "Bus " + juce::String(bus + 1) + " " + ParamTable[idx].id;
+}
+
+/* static */ juce::AudioProcessorValueTreeState::ParameterLayout MultiBusEQAudioProcessor::createParamLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    juce::SharedResourcePointer<SharedResources> shared; // Choice labels, built once per process
+
+    // Same ranges as the single bus processor, bus after bus
+    for (int bus = 0; bus < MultiBus::MaxBuses; bus++) {
+        for (int p = 0; p < MultiBus::NumBusParams; p++) {
+            const auto& desc = ParamTable[(size_t) p];
+            const auto id = GetBusParamId(bus, desc.idx);
+            if (desc.isChoice()) {
+                layout.add(std::make_unique<juce::AudioParameterChoice>(id, id,
+                    shared->getChoiceLabels(desc.idx), static_cast<int>(desc.dflt)));
+            } else {
+                layout.add(std::make_unique<juce::AudioParameterFloat>(
+                    id, id,
+                    juce::NormalisableRange<float>(desc.minVal, desc.maxVal, desc.interval, desc.skew), desc.dflt));
+            }
+        }
+    }
+
+    // Shared by every bus
+    const auto& designMode = ParamTable[DesignMode];
+    layout.add(std::make_unique<juce::AudioParameterChoice>(designMode.id, designMode.id,
+        shared->getChoiceLabels(DesignMode), static_cast<int>(designMode.dflt)));
+
+    return layout;
+}
+
+void MultiBusEQAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    juce::ignoreUnused(samplesPerBlock); // Frames are a fixed size, any block length works
+    engine->prepare(sampleRate);
+    preparedSampleRate = sampleRate;
+    for (int bus = 0; bus < MultiBus::MaxBuses; bus++) {
+        appliedSettings[(size_t) bus] = getChainSettings(busParamHandles[(size_t) bus]);
+        engine->setBus(bus, appliedSettings[(size_t) bus]);
+    }
+    UpdateTail();
+    filtersDirty = false;
+}
+
+void MultiBusEQAudioProcessor::UpdateTail()
+{
+    tailSeconds = preparedSampleRate > 0.0 ? engine->getTailSamples() / preparedSampleRate : 0.0;
+}
+
+bool MultiBusEQAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+    if (layouts.inputBuses.size() != layouts.outputBuses.size()) return false;
+
+    // Each bus is processed in place: its output must be its input, mono, stereo or off
+    for (int bus = 0; bus < layouts.outputBuses.size(); bus++) {
+        const auto set = layouts.getChannelSet(false, bus);
+        if (set != layouts.getChannelSet(true, bus)) return false;
+        if (!set.isDisabled() && set != juce::AudioChannelSet::mono() && set != juce::AudioChannelSet::stereo())
+            return false;
+    }
+    return true;
+}
+
+void MultiBusEQAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    juce::ScopedNoDenormals noDenormals;
+
+    // Only the buses whose params moved are redesigned
+    const bool redesignAll = filtersDirty.exchange(false);
+    bool isRedesigned = false;
+    for (int bus = 0; bus < MultiBus::MaxBuses; bus++) {
+        const auto cs = getChainSettings(busParamHandles[(size_t) bus]);
+        if (redesignAll || cs != appliedSettings[(size_t) bus]) {
+            appliedSettings[(size_t) bus] = cs;
+            engine->setBus(bus, cs);
+            isRedesigned = true;
+        }
+    }
+    if (isRedesigned) UpdateTail();
+
+    std::array<float*, MultiBus::NumLanes> lanes {};
+    for (int bus = 0; bus < juce::jmin(getBusCount(false), MultiBus::MaxBuses); bus++) {
+        const int numChannels = juce::jmin(getChannelCountOfBus(false, bus), 2);
+        for (int ch = 0; ch < numChannels; ch++) {
+            lanes[(size_t) (2 * bus + ch)] = buffer.getWritePointer(getChannelIndexInProcessBlockBuffer(false, bus, ch));
+        }
+    }
+
+    engine->process(lanes.data(), buffer.getNumSamples());
+}
+
+juce::AudioProcessorEditor* MultiBusEQAudioProcessor::createEditor()
+{
+    return new juce::GenericAudioProcessorEditor(*this);
+}
+
+void MultiBusEQAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
+{
+    juce::MemoryOutputStream mos(destData, true);
+    mos.writeInt((int) MultiBus::StateMagic);
+    mos.writeShort((short) MultiBus::StateVersion);
+    mos.writeShort((short) (MultiBus::MaxBuses * MultiBus::NumBusParams + 1));
+    for (const auto& handles : busParamHandles) {
+        for (int p = 0; p < MultiBus::NumBusParams; p++) {
+            mos.writeFloat(handles[(size_t) p]->load());
+        }
+    }
+    mos.writeFloat(busParamHandles[0][DesignMode]->load());
+}
+
+void MultiBusEQAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    if (sizeInBytes < StateFormat::HeaderSize) return;
+
+    juce::MemoryInputStream mis(data, (size_t) sizeInBytes, false);
+    if ((juce::uint32) mis.readInt() != MultiBus::StateMagic) return;
+
+    mis.readShort(); // Version
+    const int numStored = mis.readShort();
+    if (numStored < 0 || sizeInBytes < StateFormat::HeaderSize + numStored * (int) sizeof(float)) return;
+
+    // By index, bus after bus, then the shared params. States saved before a param existed leave it as is
+    constexpr int numBusValues = MultiBus::MaxBuses * MultiBus::NumBusParams;
+    for (int i = 0; i < juce::jmin(numStored, numBusValues + 1); i++) {
+        auto* param = i < numBusValues ? busParamObjects[(size_t) (i / MultiBus::NumBusParams)][(size_t) (i % MultiBus::NumBusParams)]
+                                       : designModeParam;
+        param->setValueNotifyingHost(param->convertTo0to1(mis.readFloat()));
+    }
+
+    filtersDirty = true;
+}
+
+#if TUTORIAL_EQ_MULTI_BUS
+//==============================================================================
+// This creates new instances of the Multi-Bus plugin
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new MultiBusEQAudioProcessor();
+}
+#endif
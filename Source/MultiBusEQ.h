@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    Multi-bus EQ: up to 16 stereo EQs in one instance.
+
+    With this EQ on dozens of tracks of a template, each instance pays the
+    host's dispatch and the wrapper's overhead, and then runs its biquads
+    over 2 channels, one sample after the other. Here each bus is a pair of
+    lanes of a single engine. Each section's coefficients and states are
+    arrays over the 32 lanes (structure of arrays), and a frame of samples
+    runs the MonoChain's 9 sections over every lane at once. The inner loop
+    is over the lanes, so the compiler vectorizes it (4 AVX or 2 AVX-512
+    ops per section and sample) and the cost barely depends on how many
+    buses are on.
+
+    Every bus has its own copy of the MonoChain's 7 params ("Bus 3 Peak
+    Freq"...), designed like Tutorial_EQAudioProcessor designs its chain.
+    It is its own plugin, with its own name and plugin code:
+    MultiBus/Tutorial_EQ_MultiBus.jucer builds the same sources with
+    TUTORIAL_EQ_MULTI_BUS=1, and createPluginFilter returns this processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#ifndef TUTORIAL_EQ_MULTI_BUS
+ #define TUTORIAL_EQ_MULTI_BUS 0
+#endif
+
+
+namespace MultiBus {
+    constexpr int MaxBuses = 16;
+    constexpr int NumLanes = MaxBuses * 2;       // Left and right of each bus
+    constexpr int NumSections = 9;               // Low cut (4), peak (1), high cut (4), see GetFirstSection
+    constexpr int NumBusParams = HiCutSlope + 1; // The MonoChain's params, first in ParamTable
+    constexpr int FrameLength = 32;              // Samples moved to the lanes at once
+    constexpr double TailFloor = 1e-6;           // Same as the single bus processor's SilenceFloor
+
+    /*! \brief Binary state, same layout as StateFormat: header, then every bus' params, bus after bus, then
+        the shared ones (the design mode) */
+    constexpr juce::uint32 StateMagic = 0x4d514554; // "TEQM"
+    constexpr int StateVersion = 1;
+}
+
+
+/*! \brief The MonoChain of every bus, over the lanes. Doesn't allocate when processing */
+class MultiBusEngine
+{
+public:
+    MultiBusEngine();
+
+    void prepare(double newSampleRate);
+    void reset();
+
+    /*! \brief Redesigns both lanes of a bus. Allocates (IIR::Coefficients), like the MonoChain's redesigns */
+    void setBus(int bus, const ChainSettings& cs);
+
+    /*! \brief In place. lanes[2 b] and lanes[2 b + 1] are bus b's channels. A nullptr lane is fed silence and
+        not written, e.g. the right lane of a mono bus or a disabled bus */
+    void process(float* const* lanes, int numSamples) noexcept;
+
+    int getNumActiveSections() const { return numActiveSections; }
+    /*! \brief Samples for the longest bus' cascade to decay under TailFloor, enabled or not */
+    int getTailSamples() const;
+
+private:
+    void ProcessFrame(int numSamples) noexcept;
+    void RebuildActiveSections();
+
+    double sampleRate { 44100.0 };
+    MonoChain designChain; // Only designs, its coefficients and bypass states are copied to the lanes
+
+    // One row per section, one column per lane. A section a bus doesn't use is an identity (b0 = 1, the rest 0)
+    // on zero states. Its own states are parked meanwhile and come back with it, like a bypassed MonoChain filter's
+    alignas(64) float b0[MultiBus::NumSections][MultiBus::NumLanes];
+    alignas(64) float b1[MultiBus::NumSections][MultiBus::NumLanes];
+    alignas(64) float b2[MultiBus::NumSections][MultiBus::NumLanes];
+    alignas(64) float a1[MultiBus::NumSections][MultiBus::NumLanes];
+    alignas(64) float a2[MultiBus::NumSections][MultiBus::NumLanes];
+    alignas(64) float s1[MultiBus::NumSections][MultiBus::NumLanes];
+    alignas(64) float s2[MultiBus::NumSections][MultiBus::NumLanes];
+    float parkedS1[MultiBus::NumSections][MultiBus::NumLanes];
+    float parkedS2[MultiBus::NumSections][MultiBus::NumLanes];
+
+    alignas(64) float frame[MultiBus::FrameLength][MultiBus::NumLanes]; // Sample major: one row is every lane
+
+    std::array<std::array<bool, MultiBus::NumSections>, MultiBus::MaxBuses> isSectionOn {};
+    // Sections at least one bus uses, in cascade order. The others are skipped for every lane
+    std::array<int, MultiBus::NumSections> activeSections {};
+    int numActiveSections { 0 };
+    std::array<int, MultiBus::MaxBuses> busTailSamples {}; // From each bus' pole radii, see GetChainTailSamples
+};
+
+
+//==============================================================================
+/*! \brief 16 stereo buses in, 16 out, bus b's output is its input through its own MonoChain */
+class MultiBusEQAudioProcessor : public juce::AudioProcessor
+{
+public:
+    MultiBusEQAudioProcessor();
+    ~MultiBusEQAudioProcessor() override;
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override {}
+
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+    /*! \brief Generic editor: 112 knobs don't fit the single bus one */
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    const juce::String getName() const override { return JucePlugin_Name; } // The Multi-Bus target's own name
+
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+    bool isMidiEffect() const override { return false; }
+    double getTailLengthSeconds() const override { return tailSeconds.load(); }
+
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, const juce::String&) override {}
+
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParamLayout();
+    /*! \brief e.g. "Bus 3 Peak Freq" */
+    static juce::String GetBusParamId(int bus, ParamIdx idx);
+
+    juce::AudioProcessorValueTreeState apvts { *this, nullptr, "Parameters", createParamLayout() };
+
+    /*! \brief Indexed by ParamIdx like the single bus handles, so getChainSettings reads them. The design mode
+        is shared by every bus, the other params past the MonoChain's are nullptr */
+    const ParamHandles& getBusParamHandles(int bus) const { return busParamHandles[(size_t) bus]; }
+
+private:
+    static BusesProperties MakeBusesProperties();
+
+    std::array<ParamHandles, MultiBus::MaxBuses> busParamHandles {};
+    std::array<std::array<juce::RangedAudioParameter*, MultiBus::NumBusParams>, MultiBus::MaxBuses> busParamObjects {};
+    juce::RangedAudioParameter* designModeParam { nullptr };
+
+    /*! \brief What each bus was last designed for, only the buses whose params moved are redesigned */
+    std::array<ChainSettings, MultiBus::MaxBuses> appliedSettings;
+    std::atomic<bool> filtersDirty { true };
+    std::atomic<double> tailSeconds { 0.0 }; // The engine's, updated with the redesigns
+    double preparedSampleRate { 0.0 };
+
+    void UpdateTail();
+
+    std::unique_ptr<MultiBusEngine> engine; // Over-aligned, on the heap
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiBusEQAudioProcessor)
+};
@@ -0,0 +1,618 @@
+/*
+  ==============================================================================
+
+    Null tests, see NullTest.h
+
+  ==============================================================================
+*/
+
+#include "NullTest.h"
+#include "BlockIIR.h"
+#include "DynamicEQ.h"
+#include "MultiBusEQ.h"
+
+namespace {
+    constexpr double SampleRates[] { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    constexpr int BlockSize = 512;
+    constexpr double SignalSeconds = 1.0;
+    constexpr int BlocksPerSettings = 16; // Settings jump every ~170ms at 48kHz
+    constexpr juce::int64 Seed = 0x5eed;
+
+    enum TestSignal {
+        Impulse,
+        Sweep,
+        Noise,
+        NumSignals
+    };
+    constexpr const char* SignalNames[] { "impulse", "sweep", "noise" };
+
+    void FillSignal(juce::AudioBuffer<float>& buffer, TestSignal signal, double sampleRate)
+    {
+        auto* data = buffer.getWritePointer(0);
+        const int numSamples = buffer.getNumSamples();
+        buffer.clear();
+
+        switch (signal) {
+        case Impulse:
+            data[0] = 1.f;
+            break;
+        case Sweep: {
+            // Exponential sine sweep, 20Hz to just under Nyquist
+            const double f0 = 20.0, f1 = 0.45 * sampleRate;
+            const double k = std::log(f1 / f0) / numSamples;
+            for (int i = 0; i < numSamples; i++) {
+                const double phase = juce::MathConstants<double>::twoPi * f0 * (std::exp(k * i) - 1.0) / (k * sampleRate);
+                data[i] = 0.5f * (float) std::sin(phase);
+            }
+            break;
+        }
+        case Noise: {
+            juce::Random rng(Seed);
+            for (int i = 0; i < numSamples; i++) data[i] = 0.5f * (rng.nextFloat() * 2.f - 1.f);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    /*! \brief Snapped like the params snap them. Stays away from the neutral settings (flat cuts,
+        0 dB peak) that the processor drops, and crossfades, on purpose */
+    ChainSettings MakeRandomSettings(juce::Random& rng)
+    {
+        auto pick = [&rng](ParamIdx idx) {
+            const auto& desc = ParamTable[idx];
+            juce::NormalisableRange<float> range(desc.minVal, desc.maxVal, desc.interval, desc.skew);
+            return range.snapToLegalValue(range.convertFrom0to1(0.02f + 0.96f * rng.nextFloat()));
+        };
+
+        ChainSettings cs;
+        cs.lowCutFreq = pick(LowCutFreq);
+        cs.hiCutFreq = pick(HiCutFreq);
+        cs.peakFreq = pick(PeakFreq);
+        cs.peakGaindB = pick(PeakGain);
+        if (cs.peakGaindB == 0.f) cs.peakGaindB = ParamTable[PeakGain].interval;
+        cs.peakQ = pick(PeakQuality);
+        cs.lowCutSlope = rng.nextInt(ParamRanges::numSlopes);
+        cs.hiCutSlope = rng.nextInt(ParamRanges::numSlopes);
+        return cs;
+    }
+
+    /*! \brief Renders the whole buffer in place, in blocks, with the same settings sequence for every engine
+        of a run. Without jumps, the first settings stay */
+    void Render(NullTestEngine& engine, juce::AudioBuffer<float>& buffer, double sampleRate, juce::int64 seed, bool settingsJump)
+    {
+        engine.prepare(sampleRate, BlockSize);
+
+        juce::Random rng(seed);
+        ChainSettings cs = MakeRandomSettings(rng);
+        juce::dsp::AudioBlock<float> whole(buffer);
+
+        for (int start = 0, blockIdx = 0; start < buffer.getNumSamples(); start += BlockSize, blockIdx++) {
+            if (settingsJump && blockIdx > 0 && blockIdx % BlocksPerSettings == 0) {
+                cs = MakeRandomSettings(rng);
+            }
+            const auto numSamples = (size_t) juce::jmin(BlockSize, buffer.getNumSamples() - start);
+            auto block = whole.getSubBlock((size_t) start, numSamples);
+            engine.process(cs, block);
+        }
+    }
+
+
+    // Engines
+    // =====================================
+
+    /*! \brief The golden reference, built from the designers' raw output and nothing else of the plugin (no MonoChain,
+        ApplyChainCoefs or UpdateCutFilter): one TDF-II biquad per section. Like the plugin, each cut only plays the
+        section of its slope, and a section keeps its state while it doesn't play.
+        In double, it is the exact maths. In float, it is what a JUCE IIR::Filter computes, rounding included */
+    template <typename SampleType>
+    class ReferenceEngine : public NullTestEngine
+    {
+    public:
+        const char* getName() const override { return std::is_same_v<SampleType, double> ? "Double reference" : "Float reference"; }
+        NullTestThresholds getThresholds() const override { return { 0.f, -300.f }; }
+
+        void prepare(double sr, int blockSize) override
+        {
+            juce::ignoreUnused(blockSize);
+            sampleRate = sr;
+            lowCut = hiCut = {};
+            peak = {};
+            isDesigned = false;
+        }
+
+        void process(const ChainSettings& cs, juce::dsp::AudioBlock<float>& monoBlock) override
+        {
+            if (!isDesigned || cs != designed) {
+                const auto lowCutCoefs = MakeLowCutFilter(cs, sampleRate);
+                const auto hiCutCoefs = MakeHighCutFilter(cs, sampleRate);
+                lowCut[(size_t) cs.lowCutSlope].setCoefficients(*lowCutCoefs[cs.lowCutSlope]);
+                hiCut[(size_t) cs.hiCutSlope].setCoefficients(*hiCutCoefs[cs.hiCutSlope]);
+                peak.setCoefficients(*MakePeakFilter(cs, sampleRate));
+                designed = cs;
+                isDesigned = true;
+            }
+
+            auto& low = lowCut[(size_t) designed.lowCutSlope];
+            auto& high = hiCut[(size_t) designed.hiCutSlope];
+            auto* data = monoBlock.getChannelPointer(0);
+            for (size_t i = 0; i < monoBlock.getNumSamples(); i++) {
+                data[i] = (float) high.processSample(peak.processSample(low.processSample((SampleType) data[i])));
+            }
+
+            // IIR::Filter snaps its states once per block
+            if constexpr (std::is_same_v<SampleType, float>) {
+                for (auto* biquad : { &low, &peak, &high }) {
+                    juce::dsp::util::snapToZero(biquad->s1);
+                    juce::dsp::util::snapToZero(biquad->s2);
+                }
+            }
+        }
+
+    private:
+        struct Biquad {
+            SampleType b0 { 1 }, b1 {}, b2 {}, a1 {}, a2 {};
+            SampleType s1 {}, s2 {};
+
+            void setCoefficients(const juce::dsp::IIR::Coefficients<float>& coefs)
+            {
+                // b0 b1 b2 a1 a2, or b0 b1 a1 for 1st order (a0 is normalised away)
+                const auto& raw = coefs.coefficients;
+                b0 = raw[0];
+                b1 = raw[1];
+                b2 = raw.size() >= 5 ? raw[2] : SampleType {};
+                a1 = raw.size() >= 5 ? raw[3] : raw[2];
+                a2 = raw.size() >= 5 ? raw[4] : SampleType {};
+            }
+
+            SampleType processSample(SampleType x)
+            {
+                const SampleType y = b0 * x + s1;
+                s1 = b1 * x - a1 * y + s2;
+                s2 = b2 * x - a2 * y;
+                return y;
+            }
+        };
+
+        std::array<Biquad, 4> lowCut, hiCut;
+        Biquad peak;
+        double sampleRate { 44100.0 };
+        ChainSettings designed;
+        bool isDesigned { false };
+    };
+
+    /*! \brief The RBJ cookbook bell, designed and run in double from the formulas. The cuts stay flat */
+    class BellReference : public NullTestEngine
+    {
+    public:
+        const char* getName() const override { return "RBJ bell reference"; }
+        NullTestThresholds getThresholds() const override { return { 0.f, -300.f }; }
+
+        void prepare(double sr, int blockSize) override
+        {
+            juce::ignoreUnused(blockSize);
+            sampleRate = sr;
+            s1 = s2 = 0.0;
+            isDesigned = false;
+        }
+
+        void process(const ChainSettings& cs, juce::dsp::AudioBlock<float>& monoBlock) override
+        {
+            if (!isDesigned || cs != designed) {
+                const double A = std::pow(10.0, cs.peakGaindB / 40.0);
+                const double w = juce::MathConstants<double>::twoPi * cs.peakFreq / sampleRate;
+                const double alpha = std::sin(w) / (2.0 * cs.peakQ);
+                const double a0 = 1.0 + alpha / A;
+                b0 = (1.0 + alpha * A) / a0;
+                b1 = a1 = -2.0 * std::cos(w) / a0;
+                b2 = (1.0 - alpha * A) / a0;
+                a2 = (1.0 - alpha / A) / a0;
+                designed = cs;
+                isDesigned = true;
+            }
+
+            auto* data = monoBlock.getChannelPointer(0);
+            for (size_t i = 0; i < monoBlock.getNumSamples(); i++) {
+                const double x = data[i];
+                const double y = b0 * x + s1;
+                s1 = b1 * x - a1 * y + s2;
+                s2 = b2 * x - a2 * y;
+                data[i] = (float) y;
+            }
+        }
+
+    private:
+        double b0 { 1.0 }, b1 {}, b2 {}, a1 {}, a2 {};
+        double s1 {}, s2 {};
+        double sampleRate { 44100.0 };
+        ChainSettings designed;
+        bool isDesigned { false };
+    };
+
+    /*! \brief Coefficients designed once per settings and shared by pointer, as the factory programs are */
+    class SharedCoefsEngine : public NullTestEngine
+    {
+    public:
+        const char* getName() const override { return "Shared ChainCoefs"; }
+        NullTestThresholds getThresholds() const override { return { 0.f, -300.f }; } // Same maths as the float reference, bit exact
+
+        void prepare(double sr, int blockSize) override
+        {
+            sampleRate = sr;
+            chain.prepare({ sr, (juce::uint32) blockSize, 1 });
+            chain.reset();
+            cache.clear();
+            current = -1;
+        }
+
+        void process(const ChainSettings& cs, juce::dsp::AudioBlock<float>& monoBlock) override
+        {
+            if (current < 0 || cache[(size_t) current].first != cs) {
+                auto found = std::find_if(cache.begin(), cache.end(), [&cs](const auto& entry) { return entry.first == cs; });
+                if (found == cache.end()) {
+                    found = cache.insert(cache.end(), { cs, MakeChainCoefs(cs, sampleRate) });
+                }
+                current = (int) std::distance(cache.begin(), found);
+                ApplyChainCoefs(chain, found->second, cs);
+            }
+            chain.process(juce::dsp::ProcessContextReplacing<float>(monoBlock));
+        }
+
+    private:
+        MonoChain chain;
+        double sampleRate { 44100.0 };
+        std::vector<std::pair<ChainSettings, ChainCoefs>> cache;
+        int current { -1 };
+    };
+
+    /*! \brief The reference's chain, its biquads run K samples per step by BlockIIRChain */
+    class BlockIIREngine : public NullTestEngine
+    {
+    public:
+        explicit BlockIIREngine(int lookAhead) : K(lookAhead) {}
+
+        const char* getName() const override { return K == 4 ? "Block IIR K=4" : "Block IIR K=8"; }
+        bool hasDoubleStates() const override { return true; }
+        // NOTE: Its states are double, so is the reference it runs against. What is left is the float products of
+        // each step's outputs, ~-140 dB worst case (48dB/Oct low cut at 20Hz, 192kHz)
+        NullTestThresholds getThresholds() const override { return { 1e-5f, -130.f }; }
+
+        void prepare(double sr, int blockSize) override
+        {
+            sampleRate = sr;
+            chain.prepare({ sr, (juce::uint32) blockSize, 1 });
+            blockChain.prepare(K);
+            isDesigned = false;
+        }
+
+        void process(const ChainSettings& cs, juce::dsp::AudioBlock<float>& monoBlock) override
+        {
+            if (!isDesigned || cs != designed) {
+                ConfigureMonoChain(chain, cs, sampleRate);
+                designed = cs;
+                isDesigned = true;
+            }
+            blockChain.process(chain, monoBlock.getChannelPointer(0), (int) monoBlock.getNumSamples());
+        }
+
+    private:
+        const int K;
+        MonoChain chain; // Only holds the coefficients
+        BlockIIRChain blockChain;
+        double sampleRate { 44100.0 };
+        ChainSettings designed;
+        bool isDesigned { false };
+    };
+
+    /*! \brief The reference's chain, its sections run by one of the cascade kernels (BlockIIRChain with a look ahead of 1) */
+    class CascadeKernelEngine : public NullTestEngine
+    {
+    public:
+        explicit CascadeKernelEngine(KernelIsa kernelIsa)
+            : isa(kernelIsa), name(juce::String("Cascade kernel ") + GetKernelIsaName(kernelIsa)) {}
+
+        const char* getName() const override { return name.toRawUTF8(); }
+        NullTestThresholds getThresholds() const override { return { 0.f, -300.f }; } // Rounds like IIR::Filter, bit exact
+
+        void prepare(double sr, int blockSize) override
+        {
+            sampleRate = sr;
+            chain.prepare({ sr, (juce::uint32) blockSize, 1 });
+            blockChain.prepare(1);
+            blockChain.setKernel(GetCascadeKernel(isa));
+            isDesigned = false;
+        }
+
+        void process(const ChainSettings& cs, juce::dsp::AudioBlock<float>& monoBlock) override
+        {
+            if (!isDesigned || cs != designed) {
+                ConfigureMonoChain(chain, cs, sampleRate);
+                designed = cs;
+                isDesigned = true;
+            }
+            blockChain.process(chain, monoBlock.getChannelPointer(0), (int) monoBlock.getNumSamples());
+        }
+
+    private:
+        const KernelIsa isa;
+        const juce::String name;
+        MonoChain chain; // Only holds the coefficients
+        BlockIIRChain blockChain;
+        double sampleRate { 44100.0 };
+        ChainSettings designed;
+        bool isDesigned { false };
+    };
+
+    /*! \brief DynamicPeakBand with a constant envelope (ratio 1, no range): the static bell it must match */
+    class DynamicPeakEngine : public NullTestEngine
+    {
+    public:
+        const char* getName() const override { return "Dynamic peak, constant envelope"; }
+        // Against the double RBJ bell. What is left is the Padé exp of the gain: ~-123 dB worst case, at +22.5 dB
+        NullTestThresholds getThresholds() const override { return { 1e-5f, -120.f }; }
+        std::unique_ptr<NullTestEngine> makeReference() const override { return std::make_unique<BellReference>(); }
+        bool keepsSettings() const override { return true; }
+
+        void prepare(double sr, int blockSize) override
+        {
+            juce::ignoreUnused(blockSize);
+            sampleRate = sr;
+            isPrepared = false;
+        }
+
+        void process(const ChainSettings& cs, juce::dsp::AudioBlock<float>& monoBlock) override
+        {
+            if (!isPrepared) {
+                DynamicBandSettings settings;
+                settings.freq = cs.peakFreq;
+                settings.gaindB = cs.peakGaindB;
+                settings.q = cs.peakQ;
+                settings.ratio = 1.f;
+                settings.rangedB = 0.f;
+                band.prepare(sampleRate, settings); // No glide from the defaults
+                isPrepared = true;
+            }
+
+            float* channels[] { monoBlock.getChannelPointer(0) };
+            band.process(channels, 1, nullptr, 0, (int) monoBlock.getNumSamples());
+        }
+
+    private:
+        DynamicPeakBand band;
+        double sampleRate { 44100.0 };
+        bool isPrepared { false };
+    };
+
+    /*! \brief One lane of MultiBusEngine. The other buses are set so that every section runs for all the lanes: the
+        sections the tested bus doesn't play run as identities on it. The other lanes are fed silence */
+    class MultiBusLaneEngine : public NullTestEngine
+    {
+    public:
+        explicit MultiBusLaneEngine(int laneIdx)
+            : lane(laneIdx), bus(laneIdx / 2),
+              name(juce::String("Multi-bus engine, bus ") + juce::String(laneIdx / 2 + 1) + (laneIdx % 2 == 0 ? " left" : " right")) {}
+
+        const char* getName() const override { return name.toRawUTF8(); }
+        // NOTE: The lane loop is the float reference's TDF-II, expression for expression: bit exact, as long as the
+        // build doesn't contract it into FMAs (the targets build for baseline x86-64, like the other bit exact engines)
+        NullTestThresholds getThresholds() const override { return { 0.f, -300.f }; }
+
+        void prepare(double sr, int blockSize) override
+        {
+            juce::ignoreUnused(blockSize);
+            engine = std::make_unique<MultiBusEngine>(); // Over-aligned, on the heap
+            engine->prepare(sr);
+
+            // Each cut plays the section of its slope: with every slope among the other buses, every section runs
+            ChainSettings others;
+            others.peakFreq = 1000.f;
+            others.peakGaindB = 6.f;
+            others.lowCutFreq = 200.f;
+            others.hiCutFreq = 5000.f;
+            for (int b = 0; b < MultiBus::MaxBuses; b++) {
+                if (b == bus) continue;
+                others.lowCutSlope = others.hiCutSlope = b % ParamRanges::numSlopes;
+                engine->setBus(b, others);
+            }
+            isDesigned = false;
+        }
+
+        void process(const ChainSettings& cs, juce::dsp::AudioBlock<float>& monoBlock) override
+        {
+            if (!isDesigned || cs != designed) {
+                engine->setBus(bus, cs);
+                designed = cs;
+                isDesigned = true;
+            }
+
+            std::array<float*, MultiBus::NumLanes> lanes {};
+            lanes[(size_t) lane] = monoBlock.getChannelPointer(0);
+            engine->process(lanes.data(), (int) monoBlock.getNumSamples());
+        }
+
+    private:
+        const int lane, bus;
+        const juce::String name;
+        std::unique_ptr<MultiBusEngine> engine;
+        ChainSettings designed;
+        bool isDesigned { false };
+    };
+
+    /*! \brief The whole plugin, through processBlock: neutral bands, silence sleep, redesign on change...
+        Fed the same signal on both channels, the left one is compared. Re-blocked, each block is handed over like
+        an erratic host does: a control period, then tiny calls at unaligned addresses */
+    class ProcessorEngine : public NullTestEngine
+    {
+    public:
+        explicit ProcessorEngine(ChainEngineIdx chainEngine, bool reblocked = false)
+            : engine(chainEngine), isReblocked(reblocked),
+              name(juce::String("Tutorial_EQAudioProcessor, ") + ChainEngineChoices[chainEngine] + (reblocked ? ", re-blocked" : "")) {}
+
+        const char* getName() const override { return name.toRawUTF8(); }
+        bool hasDoubleStates() const override { return engine == BlockIIR4 || engine == BlockIIR8; }
+        // Sleeping zeroes tails that are already under the -120 dB silence floor
+        NullTestThresholds getThresholds() const override { return { 1e-5f, -100.f }; }
+
+        void prepare(double sr, int blockSize) override
+        {
+            sampleRate = sr;
+            maxBlockSize = blockSize;
+            processor = std::make_unique<Tutorial_EQAudioProcessor>();
+            processor->setGovernorEnabled(false); // A slow (or loaded) test machine must not change what is compared
+            stereo.setSize(2, blockSize);
+            isPrepared = false;
+        }
+
+        void process(const ChainSettings& cs, juce::dsp::AudioBlock<float>& monoBlock) override
+        {
+            SetParam(LowCutFreq, cs.lowCutFreq);
+            SetParam(HiCutFreq, cs.hiCutFreq);
+            SetParam(PeakFreq, cs.peakFreq);
+            SetParam(PeakGain, cs.peakGaindB);
+            SetParam(PeakQuality, cs.peakQ);
+            SetParam(LowCutSlope, (float) cs.lowCutSlope);
+            SetParam(HiCutSlope, (float) cs.hiCutSlope);
+            SetParam(ChainEngine, (float) engine);
+            SetParam(Reblocking, (float) (isReblocked ? ReblockingOn : ReblockingOff));
+
+            // Like a host: params restored first, then prepared, so the first block doesn't fade anything in
+            if (!isPrepared) {
+                processor->setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+                processor->prepareToPlay(sampleRate, maxBlockSize);
+                isPrepared = true;
+            }
+
+            const int numSamples = (int) monoBlock.getNumSamples();
+            stereo.setSize(2, numSamples, false, false, true);
+            for (int ch = 0; ch < 2; ch++) {
+                stereo.copyFrom(ch, 0, monoBlock.getChannelPointer(0), numSamples);
+            }
+            juce::MidiBuffer midi;
+            if (isReblocked) {
+                // The first call takes the new settings, the short ones after it skip the control work
+                static constexpr int CallSizes[] { Tutorial_EQAudioProcessor::MaxControlPeriod, 1, 7, 3, 13, 5, 69 };
+                for (int start = 0, call = 0; start < numSamples; call = (call + 1) % (int) std::size(CallSizes)) {
+                    const int n = juce::jmin(CallSizes[call], numSamples - start);
+                    juce::AudioBuffer<float> hostCall(stereo.getArrayOfWritePointers(), 2, start, n);
+                    processor->processBlock(hostCall, midi);
+                    start += n;
+                }
+            } else {
+                processor->processBlock(stereo, midi);
+            }
+            juce::FloatVectorOperations::copy(monoBlock.getChannelPointer(0), stereo.getReadPointer(0), numSamples);
+        }
+
+    private:
+        void SetParam(ParamIdx idx, float value)
+        {
+            auto* param = processor->apvts.getParameter(ParamTable[idx].id);
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+        }
+
+        const ChainEngineIdx engine;
+        const bool isReblocked;
+        const juce::String name;
+        std::unique_ptr<Tutorial_EQAudioProcessor> processor;
+        juce::AudioBuffer<float> stereo;
+        double sampleRate { 44100.0 };
+        int maxBlockSize { 0 };
+        bool isPrepared { false };
+    };
+}
+
+
+// Class functions
+//==============================================================================
+std::unique_ptr<NullTestEngine> NullTestEngine::makeReference() const
+{
+    if (hasDoubleStates()) return std::make_unique<ReferenceEngine<double>>();
+    return std::make_unique<ReferenceEngine<float>>();
+}
+
+
+// Free functions
+
+std::vector<std::unique_ptr<NullTestEngine>> MakeNullTestEngines()
+{
+    std::vector<std::unique_ptr<NullTestEngine>> engines;
+    engines.push_back(std::make_unique<SharedCoefsEngine>());
+    for (int engine = ScalarChain; engine <= KernelCascade; engine++) {
+        engines.push_back(std::make_unique<ProcessorEngine>(static_cast<ChainEngineIdx>(engine)));
+    }
+    engines.push_back(std::make_unique<ProcessorEngine>(BlockIIR4, true));
+    engines.push_back(std::make_unique<ProcessorEngine>(BlockIIR8, true));
+    engines.push_back(std::make_unique<BlockIIREngine>(4));
+    engines.push_back(std::make_unique<BlockIIREngine>(8));
+    engines.push_back(std::make_unique<DynamicPeakEngine>());
+    engines.push_back(std::make_unique<MultiBusLaneEngine>(0));
+    engines.push_back(std::make_unique<MultiBusLaneEngine>(MultiBus::NumLanes - 1));
+    for (int i = 0; i < static_cast<int>(KernelIsa::NumIsas); i++) {
+        if (IsKernelIsaSupported(static_cast<KernelIsa>(i))) {
+            engines.push_back(std::make_unique<CascadeKernelEngine>(static_cast<KernelIsa>(i)));
+        }
+    }
+    return engines;
+}
+
+std::vector<NullTestResult> RunNullTests(NullTestEngine& engine)
+{
+    std::vector<NullTestResult> results;
+    const auto reference = engine.makeReference();
+    const auto thresholds = engine.getThresholds();
+    const bool settingsJump = !engine.keepsSettings();
+
+    for (double sampleRate : SampleRates) {
+        const int numSamples = (int) (SignalSeconds * sampleRate);
+        juce::AudioBuffer<float> expected(1, numSamples), actual(1, numSamples);
+
+        for (int signal = 0; signal < NumSignals; signal++) {
+            FillSignal(expected, static_cast<TestSignal>(signal), sampleRate);
+            actual.makeCopyOf(expected);
+
+            // Each run its own settings sequence, the same for both
+            const auto seed = Seed + (juce::int64) sampleRate * NumSignals + signal;
+            Render(*reference, expected, sampleRate, seed, settingsJump);
+            Render(engine, actual, sampleRate, seed, settingsJump);
+
+            double maxError = 0.0, diffEnergy = 0.0, refEnergy = 0.0;
+            const auto* ref = expected.getReadPointer(0);
+            const auto* out = actual.getReadPointer(0);
+            for (int i = 0; i < numSamples; i++) {
+                const double diff = (double) out[i] - (double) ref[i];
+                maxError = juce::jmax(maxError, std::abs(diff));
+                diffEnergy += diff * diff;
+                refEnergy += (double) ref[i] * ref[i];
+            }
+
+            NullTestResult result;
+            result.engine = engine.getName();
+            result.signal = SignalNames[signal];
+            result.sampleRate = sampleRate;
+            result.maxAbsError = (float) maxError;
+            result.nullDepthDb = refEnergy > 0.0
+                ? (float) juce::Decibels::gainToDecibels(std::sqrt(diffEnergy / refEnergy), -300.0)
+                : -300.f;
+            result.passed = result.maxAbsError <= thresholds.maxAbsError && result.nullDepthDb <= thresholds.maxNullDepthDb;
+            results.push_back(result);
+        }
+    }
+    return results;
+}
+
+bool RunAllNullTests()
+{
+    bool allPassed = true;
+
+    for (auto& engine : MakeNullTestEngines()) {
+        for (const auto& result : RunNullTests(*engine)) {
+            juce::Logger::writeToLog(juce::String(result.passed ? "PASS " : "FAIL ")
+                                     + result.engine + ", " + result.signal + " @ " + juce::String(result.sampleRate, 0)
+                                     + "Hz: max error " + juce::String(result.maxAbsError, 9)
+                                     + ", null depth " + juce::String(result.nullDepthDb, 1) + " dB");
+            allPassed = allPassed && result.passed;
+        }
+    }
+    return allPassed;
+}
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    Null tests: proof that an optimized engine sounds like the reference.
+
+    The reference is built from the designers' output only (MakePeakFilter,
+    MakeLowCutFilter, MakeHighCutFilter), one TDF-II biquad per section,
+    in float for the engines that compute like IIR::Filter and in double
+    for the ones with double states. None of the plugin's chain code runs.
+    Each engine runs side by side with it over impulses, sweeps and noise,
+    at every common sample rate, while the settings jump around randomly
+    (seeded, so a failure reproduces). The difference gives the max absolute
+    error and the null depth (RMS of the difference relative to the RMS of
+    the reference), both checked against the engine's own thresholds.
+
+    The dynamic peak band is the exception: a TPT SVF, it can't follow the
+    biquad through a coefficient jump, and it is a bell only. It runs with a
+    constant envelope, against an RBJ bell designed in double, with one
+    random setting per run.
+
+    Runs headless in the Tutorial_EQ_Tests console app (Tests/), which logs
+    the report and exits with 1 on failure.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+
+/*! \brief Max error allowed for an engine. Bit exact engines can ask for 0 */
+struct NullTestThresholds {
+    float maxAbsError;
+    float maxNullDepthDb; // e.g. -100 means the difference must be at least 100 dB under the signal
+};
+
+/*! \brief What is checked against the reference: a mono EQ driven by ChainSettings */
+class NullTestEngine
+{
+public:
+    virtual ~NullTestEngine() = default;
+
+    virtual const char* getName() const = 0;
+    virtual NullTestThresholds getThresholds() const = 0;
+    /*! \brief Checked against the double precision reference, otherwise against the float one */
+    virtual bool hasDoubleStates() const { return false; }
+    /*! \brief What it is checked against: one of the references above, unless it tests something else */
+    virtual std::unique_ptr<NullTestEngine> makeReference() const;
+    /*! \brief Each run keeps its first settings, for engines that only match the reference in steady state */
+    virtual bool keepsSettings() const { return false; }
+
+    virtual void prepare(double sampleRate, int blockSize) = 0;
+    /*! \brief cs may differ from the previous block's, like params under automation */
+    virtual void process(const ChainSettings& cs, juce::dsp::AudioBlock<float>& monoBlock) = 0;
+};
+
+struct NullTestResult {
+    juce::String engine, signal;
+    double sampleRate;
+    float maxAbsError, nullDepthDb;
+    bool passed;
+};
+
+/*! \brief Every engine to check. New engines are added here */
+std::vector<std::unique_ptr<NullTestEngine>> MakeNullTestEngines();
+
+std::vector<NullTestResult> RunNullTests(NullTestEngine& engine);
+
+/*! \brief Runs every engine, logs one line per run. Returns false if any failed */
+bool RunAllNullTests();
@@ -119,26 +119,24 @@ juce::Rectangle<int> CustomRotSlider::getSliderBounds() const
 //==============================================================================
 Tutorial_EQAudioProcessorEditor::Tutorial_EQAudioProcessorEditor (Tutorial_EQAudioProcessor& p)
     : AudioProcessorEditor (&p),
-    // Call constructors for the custom sliders
-    peakFreqSlider(*audioProcessor.apvts.getParameter("LowCut Freq"), "Hz"),
-    peakGainSlider(*audioProcessor.apvts.getParameter("HighCut Freq"), "Hz"),
-    peakQSlider(*audioProcessor.apvts.getParameter("Peak Freq"), "Hz"),
-    lowCutSlider(*audioProcessor.apvts.getParameter("Peak Gain"), "dB"),
-    hiCutSlider(*audioProcessor.apvts.getParameter("Peak Quality"), ""),
-    lowCutSlopeSlider(*audioProcessor.apvts.getParameter("LowCut Slope"), "dB/Oct"),
-    hiCutSlopeSlider(*audioProcessor.apvts.getParameter("HighCut Slope"), "dB/Oct"),
-
     audioProcessor (p),
-    respCurveComponent(audioProcessor),
-    // TODO: do enum to iterate
-    lowCutSliderAttach(audioProcessor.apvts, "LowCut Freq", lowCutSlider),
-    hiCutSliderAttach(audioProcessor.apvts, "HighCut Freq", hiCutSlider),
-    peakFreqSliderAttach(audioProcessor.apvts, "Peak Freq", peakFreqSlider),
-    peakGainSliderAttach(audioProcessor.apvts, "Peak Gain", peakGainSlider),
-    peakQSliderAttach(audioProcessor.apvts, "Peak Quality", peakQSlider),
-    lowCutSlopeSliderAttach(audioProcessor.apvts, "LowCut Slope", lowCutSlopeSlider),
-    hiCutSlopeSliderAttach(audioProcessor.apvts, "HighCut Slope", hiCutSlopeSlider)
+    // Call constructors for the custom sliders
+    peakFreqSlider(getParam(PeakFreq), ParamTable[PeakFreq].suffix),
+    peakGainSlider(getParam(PeakGain), ParamTable[PeakGain].suffix),
+    peakQSlider(getParam(PeakQuality), ParamTable[PeakQuality].suffix),
+    lowCutSlider(getParam(LowCutFreq), ParamTable[LowCutFreq].suffix),
+    hiCutSlider(getParam(HiCutFreq), ParamTable[HiCutFreq].suffix),
+    lowCutSlopeSlider(getParam(LowCutSlope), ParamTable[LowCutSlope].suffix),
+    hiCutSlopeSlider(getParam(HiCutSlope), ParamTable[HiCutSlope].suffix),
+
+    respCurveComponent(audioProcessor)
 {
+    auto sliders = getSliders();
+    for (const auto& desc : ParamTable) {
+        if (sliders[desc.idx] == nullptr) continue; // No knob for this param, only the host shows it
+        attachments[desc.idx] = std::make_unique<Attachment>(audioProcessor.apvts, desc.id, *sliders[desc.idx]);
+    }
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
     for (auto* comp : getComps()) {
@@ -146,6 +144,10 @@ Tutorial_EQAudioProcessorEditor::Tutorial_EQAudioProcessorEditor (Tutorial_EQAud
     }
 
     setSize (WINDOW_WIDTH, WINDOW_HEIGHT);
+
+   #if TUTORIAL_EQ_ENABLE_TRACING
+    setWantsKeyboardFocus(true);
+   #endif
 }
 
 Tutorial_EQAudioProcessorEditor::~Tutorial_EQAudioProcessorEditor()
@@ -162,6 +164,7 @@ void Tutorial_EQAudioProcessorEditor::paint (juce::Graphics& g)
 
 void RespCurveCmp::paint (juce::Graphics& g)
 {
+    EQ_TRACE_SCOPE("RespCurveCmp::paint");
 /* This is for demonstration purposes. Very inefficient, calculates the magnitude (Y pos) for each pixel (X pos)
 wide in the graph, so you run through the X axis and stop at every pixel to calculate where the line is drawn there
 
@@ -174,51 +177,46 @@ Ideas to optimize:
     auto bounds = getLocalBounds(); // Were already configured in editor.resised
     auto graphWidth = bounds.getWidth(); // width of the EQ graph in pixels
 
-    auto& lowCut = monochain.get<MonoChainIdx::LowCut>();
-    auto& peak = monochain.get<MonoChainIdx::Peak>();
-    auto& hiCut = monochain.get<MonoChainIdx::HiCut>();
+    // The first paint designs the chain, not the constructor (see RespCurveCmp)
+    if (is_params_changed.get()) {
+        UpdateMonoChain();
+    }
 
-    //  (e.g., 44100 Hz, 48000 Hz). This is needed to calculate the filter's magnitude response at specific frequencies.
-    auto srate = audioProcessor.getSampleRate();
+    if (isCurveDirty && graphWidth > 0) {
+        isCurveDirty = false;
 
-    std::vector<double> mags;
-    mags.resize(graphWidth);
+        //  (e.g., 44100 Hz, 48000 Hz). This is needed to calculate the filter's magnitude response at specific frequencies.
+        auto srate = audioProcessor.getSampleRate();
 
-    for (size_t i = 0; i < graphWidth; i++) {
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(graphWidth), 20.0, 20000.0);
+        std::vector<double> mags;
+        mags.resize(graphWidth);
 
-        if (!monochain.isBypassed<MonoChainIdx::Peak>()) {
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, srate);
+        if (logFreqGrid == nullptr || (int) logFreqGrid->size() != graphWidth) {
+            logFreqGrid = sharedResources->getLogFreqGrid(graphWidth);
         }
-        if (!lowCut.isBypassed<0>()) mag *= lowCut.get<0>().coefficients->getMagnitudeForFrequency(freq, srate);
-        if (!lowCut.isBypassed<1>()) mag *= lowCut.get<1>().coefficients->getMagnitudeForFrequency(freq, srate);
-        if (!lowCut.isBypassed<2>()) mag *= lowCut.get<2>().coefficients->getMagnitudeForFrequency(freq, srate);
-        if (!lowCut.isBypassed<3>()) mag *= lowCut.get<3>().coefficients->getMagnitudeForFrequency(freq, srate);
-        
-        if (!hiCut.isBypassed<0>()) mag *= hiCut.get<0>().coefficients->getMagnitudeForFrequency(freq, srate);
-        if (!hiCut.isBypassed<1>()) mag *= hiCut.get<1>().coefficients->getMagnitudeForFrequency(freq, srate);
-        if (!hiCut.isBypassed<2>()) mag *= hiCut.get<2>().coefficients->getMagnitudeForFrequency(freq, srate);
-        if (!hiCut.isBypassed<3>()) mag *= hiCut.get<3>().coefficients->getMagnitudeForFrequency(freq, srate);
-
-        mags[i] = Decibels::gainToDecibels(mag);
-    }
 
-    Path respCurve;
+        for (size_t i = 0; i < graphWidth; i++) {
+            auto freq = (*logFreqGrid)[i];
+            double mag = GetChainMagnitudeForFrequency(monochain, freq, srate);
+
+            mags[i] = Decibels::gainToDecibels(mag);
+        }
 
-    const double outMin = bounds.getBottom();
-    const double outMax = bounds.getY();
+        const double outMin = bounds.getBottom();
+        const double outMax = bounds.getY();
 
-    auto map = [outMin, outMax](double input)
-    {
-        // -24 to 24 is the range of the Peak band gain
-        return jmap(input, -24.0, 24.0, outMin, outMax);
-    };
+        auto map = [outMin, outMax](double input)
+        {
+            // -24 to 24 is the range of the Peak band gain
+            return jmap(input, -24.0, 24.0, outMin, outMax);
+        };
 
-    respCurve.startNewSubPath(bounds.getX(), map(mags.front()));
+        respCurve.clear();
+        respCurve.startNewSubPath(bounds.getX(), map(mags.front()));
 
-    for (size_t i = 0; i < mags.size(); i++) {
-        respCurve.lineTo(bounds.getX() + i, map(mags[i]));
+        for (size_t i = 0; i < mags.size(); i++) {
+            respCurve.lineTo(bounds.getX() + i, map(mags[i]));
+        }
     }
     
     g.setColour(Colours::orange);
@@ -226,6 +224,15 @@ Ideas to optimize:
 
     g.setColour(Colours::white);
     g.strokePath(respCurve, PathStrokeType(2.f));
+
+    // Not full quality: the CPU governor is saving time, the user should know why it sounds different
+    shownTierChanges = audioProcessor.getNumTierChanges();
+    const auto tier = audioProcessor.getQualityTier();
+    if (tier != QualityTier::Full) {
+        g.setColour(Colours::orange);
+        g.setFont(12.f);
+        g.drawText(String("CPU: ") + QualityTierNames[static_cast<int>(tier)], bounds.reduced(6), Justification::topLeft);
+    }
 }
 
 void Tutorial_EQAudioProcessorEditor::resized()
@@ -257,6 +264,21 @@ void Tutorial_EQAudioProcessorEditor::resized()
     
 }
 
+#if TUTORIAL_EQ_ENABLE_TRACING
+bool Tutorial_EQAudioProcessorEditor::keyPressed(const juce::KeyPress& key)
+{
+    const auto exportKey = juce::KeyPress('t', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0);
+    if (key != exportKey) {
+        return false;
+    }
+
+    const auto file = juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
+                          .getNonexistentChildFile("Tutorial_EQ_trace", ".json");
+    Trace::WriteChromeJson(file);
+    return true;
+}
+#endif
+
 
 std::vector<juce::Component*> Tutorial_EQAudioProcessorEditor::getComps()
 {
@@ -266,30 +288,66 @@ std::vector<juce::Component*> Tutorial_EQAudioProcessorEditor::getComps()
 }
 
 
+std::array<CustomRotSlider*, NumParams> Tutorial_EQAudioProcessorEditor::getSliders()
+{
+    std::array<CustomRotSlider*, NumParams> sliders {};
+    sliders[LowCutFreq] = &lowCutSlider;
+    sliders[HiCutFreq] = &hiCutSlider;
+    sliders[PeakFreq] = &peakFreqSlider;
+    sliders[PeakGain] = &peakGainSlider;
+    sliders[PeakQuality] = &peakQSlider;
+    sliders[LowCutSlope] = &lowCutSlopeSlider;
+    sliders[HiCutSlope] = &hiCutSlopeSlider;
+    // PhaseMode, FirLength, the dynamic peak's params and the modes have no knob, they stay nullptr
+    return sliders;
+}
+
+juce::RangedAudioParameter& Tutorial_EQAudioProcessorEditor::getParam(ParamIdx idx)
+{
+    auto* param = audioProcessor.apvts.getParameter(ParamTable[idx].id);
+    jassert(param != nullptr);
+    return *param;
+}
+
+
 void RespCurveCmp::timerCallback()
 {
+    EQ_TRACE_SCOPE("RespCurveCmp::timerCallback");
     // addListener() must be called for this to work, i.e. we need to listen to our parameters
     // to know if they have changed
 
     // Update the editor's monochain
     if(is_params_changed.get() == true) {
-        is_params_changed.set(false);
-        auto cs = getChainSettings(audioProcessor.apvts);
-        auto pkcoefs = MakePeakFilter(cs, audioProcessor.getSampleRate());
-        UpdateCoefficients(monochain.get<MonoChainIdx::Peak>().coefficients, pkcoefs);
-
-        auto lccoefs = MakeLowCutFilter(cs, audioProcessor.getSampleRate());
-        auto hccoefs = MakeHighCutFilter(cs, audioProcessor.getSampleRate());
-
-        UpdateCutFilter(monochain.get<MonoChainIdx::LowCut>(), lccoefs, cs.lowCutSlope);
-        UpdateCutFilter(monochain.get<MonoChainIdx::HiCut>(), hccoefs, cs.hiCutSlope);
+        UpdateMonoChain();
+        repaint();
+    }
 
+    // The governor stepped down (or back up) since the last paint
+    if (audioProcessor.getNumTierChanges() != shownTierChanges) {
         repaint();
     }
 
     // repaint();
 }
 
+void RespCurveCmp::UpdateMonoChain()
+{
+    is_params_changed.set(false);
+    auto cs = getChainSettings(audioProcessor.getParamHandles());
+    ConfigureMonoChain(monochain, cs, audioProcessor.getSampleRate());
+    isCurveDirty = true;
+}
+
+void RespCurveCmp::UpdateTimer()
+{
+    // Editors of hidden windows (or not on screen yet) don't poll
+    if (isShowing()) {
+        if (!isTimerRunning()) startTimer(60);
+    } else {
+        stopTimer();
+    }
+}
+
 void RespCurveCmp::parameterValueChanged (int parameterIndex, float newValue)
 {
     is_params_changed.set(true);
@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SharedResources.h"
 
 struct MyLookAndFeel : juce::LookAndFeel_V4 // Inherit from the most recent LnF version
 {
@@ -30,7 +31,7 @@ struct CustomRotSlider : juce::Slider
                           juce::Slider::TextEntryBoxPosition::NoTextBox),
     _param(&param), _suffix(suffix)
     {
-        setLookAndFeel(&_lnf);
+        setLookAndFeel(&_lnf.get());
     }
 
     ~CustomRotSlider()
@@ -44,7 +45,7 @@ struct CustomRotSlider : juce::Slider
     int getTextHeight() const { return 14; }
     juce::String getDisplayStr() const;
 private:
-    MyLookAndFeel _lnf;
+    juce::SharedResourcePointer<MyLookAndFeel> _lnf; // Stateless, one for every knob of every editor
     juce::RangedAudioParameter* _param; // Base class for many derived (float, choice, bool, ...)
     juce::String _suffix;
 
@@ -56,12 +57,17 @@ struct RespCurveCmp:
     juce::AudioProcessorParameter::Listener,
     juce::Timer
 {
+    /*! \brief Params the curve depends on. The others (phase mode, dynamics...) never trigger a redraw */
+    static constexpr std::array<ParamIdx, 8> CurveParams {
+        LowCutFreq, HiCutFreq, PeakFreq, PeakGain, PeakQuality, LowCutSlope, HiCutSlope, DesignMode
+    };
+
+    /*! \note Cheap on purpose, hosts open editors while scanning sessions: the curve is designed on the
+        first paint, and the timer only runs while the component is on screen */
     RespCurveCmp (Tutorial_EQAudioProcessor& p)
         : audioProcessor(p) // NOTE: refs must be initialized here
     {
         toggleParameterListeners(true);
-
-        startTimer(60); // knows this fct because it inherits from the juce::Timer class`   `
     }
     ~RespCurveCmp()
     {
@@ -70,8 +76,8 @@ struct RespCurveCmp:
 
     // constructor helper
     inline void toggleParameterListeners(bool enableListeners) {
-        const auto& params = audioProcessor.getParameters(); // Returns an array of pointers
-        for (auto param : params) {
+        for (auto idx : CurveParams) {
+            auto* param = audioProcessor.apvts.getParameter(ParamTable[idx].id);
             if (enableListeners) {
                 param->addListener(this); // Adding the pluginEditor instance as a listener for each param
             } else {
@@ -82,6 +88,9 @@ struct RespCurveCmp:
 
     // Component overrides
     void paint(juce::Graphics& g) override;
+    void resized() override { isCurveDirty = true; }
+    void visibilityChanged() override { UpdateTimer(); }
+    void parentHierarchyChanged() override { UpdateTimer(); }
 
     // AudioProcessorParameter::Listener OVERRIDE FCTs
     void parameterValueChanged (int parameterIndex, float newValue) override;
@@ -95,10 +104,24 @@ private:
     Tutorial_EQAudioProcessor& audioProcessor;
     /*! \note The brace initialization is from C++11. It helps prevent implicit conversions (safer)
         it is prefered in modern cpp code. */
-    juce::Atomic<bool> is_params_changed { false };
+    juce::Atomic<bool> is_params_changed { true }; // Nothing designed yet
     
     /*! \note We must have a process chain so we can "simulate" the EQ and show what it does */
     MonoChain monochain;
+
+    /*! \brief The curve, rebuilt only when the params or the size changed */
+    juce::Path respCurve;
+    bool isCurveDirty { true };
+
+    /*! \brief The governor's tier is drawn over the curve when it isn't Full, repainted when it changes */
+    int shownTierChanges { 0 };
+
+    void UpdateMonoChain();
+    void UpdateTimer();
+
+    /*! \brief Freq of every point of the curve, shared by every editor of the same width */
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+    std::shared_ptr<const std::vector<double>> logFreqGrid;
 };
 
 
@@ -118,6 +141,11 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+   #if TUTORIAL_EQ_ENABLE_TRACING
+    /*! \brief Cmd/Ctrl+Shift+T exports the trace to the desktop */
+    bool keyPressed(const juce::KeyPress& key) override;
+   #endif
+
 
 private:
     // This reference is provided as a quick way for your editor to
@@ -132,14 +160,15 @@ private:
     RespCurveCmp respCurveComponent;
   
     
-    /*! \brief Attachments connect the sliders to params we created in Pluginprocessor */
+    /*! \brief Attachments connect the sliders to params we created in Pluginprocessor, indexed by ParamIdx */
     using Apvts = juce::AudioProcessorValueTreeState;
     using Attachment = Apvts::SliderAttachment;
-    Attachment peakFreqSliderAttach, peakGainSliderAttach, peakQSliderAttach;
-    Attachment lowCutSliderAttach, hiCutSliderAttach;
-    Attachment lowCutSlopeSliderAttach, hiCutSlopeSliderAttach;
+    std::array<std::unique_ptr<Attachment>, NumParams> attachments;
 
     std::vector<juce::Component*> getComps();
+    /*! \brief Sliders in ParamIdx order, so ParamTable can drive the attachments. nullptr if a param has no knob */
+    std::array<CustomRotSlider*, NumParams> getSliders();
+    juce::RangedAudioParameter& getParam(ParamIdx idx);
 
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Tutorial_EQAudioProcessorEditor)
@@ -8,6 +8,43 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "LinearPhaseEQ.h"
+#include "SharedResources.h"
+#include "BlockIIR.h"
+#include "MultiBusEQ.h"
+
+
+// Factory programs
+
+struct FactoryProgram {
+    const char* name;
+    ChainSettings settings; // peakFreq, peakGaindB, peakQ, lowCutFreq, hiCutFreq, lowCutSlope, hiCutSlope
+};
+
+static const std::array<FactoryProgram, 6> FactoryPrograms {{
+    { "Flat",           { 750.f,   0.f,  1.f,  20.f,  20000.f, 0, 0 } },
+    { "Vocal presence", { 3000.f,  4.f,  1.f,  100.f, 20000.f, 1, 0 } },
+    { "Kick punch",     { 60.f,    5.f,  1.4f, 20.f,  12000.f, 0, 1 } },
+    { "Bass cleanup",   { 250.f,  -4.f,  1.2f, 40.f,  8000.f,  2, 1 } },
+    { "Telephone",      { 1500.f,  6.f,  0.7f, 400.f, 3400.f,  3, 3 } },
+    { "Air",            { 12000.f, 3.f,  0.5f, 20.f,  20000.f, 0, 0 } },
+}};
+
+
+class Tutorial_EQAudioProcessor::PrepareJob : public juce::ThreadPoolJob
+{
+public:
+    explicit PrepareJob(Tutorial_EQAudioProcessor& p) : juce::ThreadPoolJob("Tutorial_EQ prepare"), processor(p) {}
+
+    JobStatus runJob() override
+    {
+        processor.PrepareInBackground();
+        return jobHasFinished;
+    }
+
+private:
+    Tutorial_EQAudioProcessor& processor;
+};
 
 
 // Free functions
@@ -15,10 +52,101 @@
 Coefs MakePeakFilter(const ChainSettings chainSettings, double sampleRate)
 {
     float gain_processed = juce::Decibels::decibelsToGain(chainSettings.peakGaindB); // as gain units, not as decibels
+    if (chainSettings.designMode == MatchedDesign) {
+        return MakeMatchedPeakFilter(sampleRate, chainSettings.peakFreq, chainSettings.peakQ, gain_processed);
+    }
     return juce::dsp::IIR::Coefficients<float>::makePeakFilter(
         sampleRate, chainSettings.peakFreq, chainSettings.peakQ, gain_processed);
 }
 
+ChainCoefs MakeChainCoefs(const ChainSettings& cs, double sampleRate)
+{
+    ChainCoefs coefs;
+    coefs.peak = MakePeakFilter(cs, sampleRate);
+    coefs.lowCut = MakeLowCutFilter(cs, sampleRate);
+    coefs.hiCut = MakeHighCutFilter(cs, sampleRate);
+    return coefs;
+}
+
+void ApplyChainCoefs(MonoChain& chain, const ChainCoefs& coefs, const ChainSettings& cs)
+{
+    // NOTE: Pointer assignment, not UpdateCoefficients: the objects may belong to a program and be shared
+    chain.get<MonoChainIdx::Peak>().coefficients = coefs.peak;
+
+    // The filter algo returns coeficients, we pass them to the chain to be applied on audio signal
+    UpdateCutFilter(chain.get<MonoChainIdx::LowCut>(), coefs.lowCut, cs.lowCutSlope);
+    UpdateCutFilter(chain.get<MonoChainIdx::HiCut>(), coefs.hiCut, cs.hiCutSlope);
+}
+
+void ConfigureMonoChain(MonoChain& chain, const ChainSettings& cs, double sampleRate)
+{
+    ApplyChainCoefs(chain, MakeChainCoefs(cs, sampleRate), cs);
+}
+
+double GetCutFilterMagnitudeForFrequency(const CutFilter& cut, double freq, double sampleRate)
+{
+    double mag = 1.f;
+
+    if (!cut.isBypassed<0>()) mag *= cut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+    if (!cut.isBypassed<1>()) mag *= cut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+    if (!cut.isBypassed<2>()) mag *= cut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+    if (!cut.isBypassed<3>()) mag *= cut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+
+    return mag;
+}
+
+double GetChainMagnitudeForFrequency(const MonoChain& chain, double freq, double sampleRate)
+{
+    double mag = 1.f;
+
+    if (!chain.isBypassed<MonoChainIdx::Peak>()) {
+        mag *= chain.get<MonoChainIdx::Peak>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+    }
+    if (!chain.isBypassed<MonoChainIdx::LowCut>()) {
+        mag *= GetCutFilterMagnitudeForFrequency(chain.get<MonoChainIdx::LowCut>(), freq, sampleRate);
+    }
+    if (!chain.isBypassed<MonoChainIdx::HiCut>()) {
+        mag *= GetCutFilterMagnitudeForFrequency(chain.get<MonoChainIdx::HiCut>(), freq, sampleRate);
+    }
+
+    return mag;
+}
+
+
+int GetChainTailSamples(const MonoChain& chain, double floorGain)
+{
+    // Cascaded sections: the tails add up (pessimistic, but never cuts a tail short)
+    juce::int64 total = 0;
+    auto addSection = [&total, floorGain](const Filter& filter) {
+        const auto* c = filter.coefficients->getRawCoefficients();
+        const double radius = filter.coefficients->getFilterOrder() == 1
+            ? std::abs(c[2])                  // b0, b1, a1
+            : GetBiquadPoleRadius(c[3], c[4]); // b0, b1, b2, a1, a2
+        total += GetDecaySamples(radius, floorGain);
+    };
+
+    auto& lowCut = chain.get<MonoChainIdx::LowCut>();
+    auto& hiCut = chain.get<MonoChainIdx::HiCut>();
+
+    if (!chain.isBypassed<MonoChainIdx::Peak>()) addSection(chain.get<MonoChainIdx::Peak>());
+
+    if (!chain.isBypassed<MonoChainIdx::LowCut>()) {
+        if (!lowCut.isBypassed<0>()) addSection(lowCut.get<0>());
+        if (!lowCut.isBypassed<1>()) addSection(lowCut.get<1>());
+        if (!lowCut.isBypassed<2>()) addSection(lowCut.get<2>());
+        if (!lowCut.isBypassed<3>()) addSection(lowCut.get<3>());
+    }
+
+    if (!chain.isBypassed<MonoChainIdx::HiCut>()) {
+        if (!hiCut.isBypassed<0>()) addSection(hiCut.get<0>());
+        if (!hiCut.isBypassed<1>()) addSection(hiCut.get<1>());
+        if (!hiCut.isBypassed<2>()) addSection(hiCut.get<2>());
+        if (!hiCut.isBypassed<3>()) addSection(hiCut.get<3>());
+    }
+
+    return (int) juce::jmin((juce::int64) MaxDecaySamples, total);
+}
+
 
 // Class functions
 //==============================================================================
@@ -28,16 +156,35 @@ Tutorial_EQAudioProcessor::Tutorial_EQAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false) // Dynamic peak's detector
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    prepareJob = std::make_unique<PrepareJob>(*this);
+
+    // Cache the raw value of every param once, processBlock then reads them by index
+    for (const auto& desc : ParamTable) {
+        paramHandles[desc.idx] = apvts.getRawParameterValue(desc.id);
+        paramObjects[desc.idx] = apvts.getParameter(desc.id);
+        jassert(paramHandles[desc.idx] != nullptr && paramObjects[desc.idx] != nullptr); // ParamTable and the layout must agree
+    }
+    for (int band = 0; band < MultiBandEQ::MaxBands; band++) {
+        for (const auto& desc : BandParamTable) {
+            const auto id = sharedResources->getBandParamId(band, desc.idx);
+            bandParamHandles[(size_t) band][desc.idx] = apvts.getRawParameterValue(id);
+            bandParamObjects[(size_t) band][desc.idx] = apvts.getParameter(id);
+            jassert(bandParamHandles[(size_t) band][desc.idx] != nullptr);
+        }
+    }
 }
 
 Tutorial_EQAudioProcessor::~Tutorial_EQAudioProcessor()
 {
+    CancelBackgroundPreparation(); // It writes our members
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -75,31 +222,52 @@ bool Tutorial_EQAudioProcessor::isMidiEffect() const
 
 double Tutorial_EQAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // Hosts that support it stop calling us once our input has been silent that long
+    return tailSeconds;
 }
 
 int Tutorial_EQAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    return (int) FactoryPrograms.size();   // NB: some hosts don't cope very well if you tell them there are 0 programs,
                 // so this should be at least 1, even if you're not really implementing programs.
 }
 
 int Tutorial_EQAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void Tutorial_EQAudioProcessor::setCurrentProgram (int index)
 {
+    if (!juce::isPositiveAndBelow(index, getNumPrograms())) return;
+
+    // The audio thread already has this program's coefficients, it only flips to them once the params,
+    // which knobs and automation show, are set
+    programParamsVersion++;
+    currentProgram = index;
+    pendingProgram = index;
+
+    const auto& cs = FactoryPrograms[(size_t) index].settings;
+    SetParamValue(LowCutFreq, cs.lowCutFreq);
+    SetParamValue(HiCutFreq, cs.hiCutFreq);
+    SetParamValue(PeakFreq, cs.peakFreq);
+    SetParamValue(PeakGain, cs.peakGaindB);
+    SetParamValue(PeakQuality, cs.peakQ);
+    SetParamValue(LowCutSlope, (float) cs.lowCutSlope);
+    SetParamValue(HiCutSlope, (float) cs.hiCutSlope);
+    programParamsVersion++;
 }
 
 const juce::String Tutorial_EQAudioProcessor::getProgramName (int index)
 {
-    return {};
+    if (!juce::isPositiveAndBelow(index, getNumPrograms())) return {};
+    return FactoryPrograms[(size_t) index].name;
 }
 
 void Tutorial_EQAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    // Factory programs can't be renamed
+    juce::ignoreUnused(index, newName);
 }
 
 //==============================================================================
@@ -108,15 +276,90 @@ void Tutorial_EQAudioProcessor::prepareToPlay (double sampleRate, int samplesPer
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
+    // NOTE: Only what the first block can't do without, the host starts playing as soon as we return.
+    // The rest is built by prepareJob, see PrepareInBackground()
+    CancelBackgroundPreparation();
+
     juce::dsp::ProcessSpec spec;
     spec.maximumBlockSize = samplesPerBlock;
     spec.numChannels = 1;
     spec.sampleRate = sampleRate;
 
-    LChain.prepare(spec);
-    RChain.prepare(spec);
+    for (auto& chain : leftChains) chain.prepare(spec);
+    for (auto& chain : rightChains) chain.prepare(spec);
 
-    UpdateFilters();
+    cascadeKernel = GetCascadeKernel(SelectKernelIsa());
+    for (auto* blockChains : { &leftBlockChains, &rightBlockChains }) {
+        for (auto& blockChain : *blockChains) {
+            if (blockChain == nullptr) blockChain = std::make_unique<BlockIIRChain>();
+            blockChain->reset();
+        }
+    }
+    fadeScratch.assign((size_t) samplesPerBlock, 0.f);
+    ResizeRetiredCoefs(samplesPerBlock);
+
+    // Whatever the param, it can be turned on while playing
+    appliedReblocking = IsReblocking(paramHandles);
+    preparedBlockSize = samplesPerBlock;
+    reblockScratch = juce::dsp::AudioBlock<float>(reblockStorage, 2, (size_t) samplesPerBlock, ReblockAlignment);
+    SelectEngine(GetChainEngine(paramHandles));
+    previousEngine = chainEngine;
+    engineFading = false;
+    samplesSinceControl = 0;
+
+    // Whatever the engine, both chains start cleared: in sync
+    identicalSamples = 0;
+    isDualMono = false;
+
+    // Program changes must not design anything on the audio thread. At a new rate, they wait for the job
+    if (sampleRate != preparedSampleRate) {
+        programCoefs = nullptr;
+        programCoefsOwner.reset();
+    }
+    programScratch.setSize(2, samplesPerBlock);
+    isProgramFading = false;
+
+    auto stereoSpec = spec;
+    stereoSpec.numChannels = MultiBandEQ::MaxChannels;
+    ApplyBandParams(); // Before prepare, so the first block doesn't fade them in
+    extraBands.prepare(stereoSpec);
+
+    dynamicPeak.prepare(sampleRate, getDynamicBandSettings(paramHandles));
+    appliedDynamicPeak = IsDynamicPeak(paramHandles);
+    peakModeFading = false;
+    peakModeScratch.setSize(2, samplesPerBlock);
+
+    appliedStereoMode = previousStereoMode = GetStereoMode(paramHandles);
+    stereoModeFading = false;
+    stereoModeScratch.setSize(2, samplesPerBlock);
+    midSideScratch.assign((size_t) samplesPerBlock, 0.f);
+
+    // Only once Phase Mode has been Linear: a template of minimum phase instances never designs a kernel
+    linearPhaseSpec = stereoSpec;
+    if (linearPhase == nullptr && IsLinearPhase(paramHandles)) {
+        linearPhase = std::make_unique<LinearPhaseEQ>();
+    }
+    if (linearPhase != nullptr) {
+        linearPhase->prepare(stereoSpec, getChainSettings(paramHandles), extraBands.getBands(), GetFirLength(paramHandles),
+                             isNonRealtime());
+        isLinearPhaseReady.store(true, std::memory_order_release);
+    }
+    targetLatency = IsLinearPhase(paramHandles) && linearPhase != nullptr
+        ? linearPhase->getLatencyForLength(GetFirLength(paramHandles)) : 0;
+    setLatencySamples(targetLatency);
+
+    governor.setEnabled(IsGovernorOn(paramHandles) && !isNonRealtime());
+    governor.prepare(sampleRate);
+    ApplyQualityTier(governor.getTier());
+
+    DesignFilters(getChainSettings(paramHandles), IsLinearPhase(paramHandles), GetFirLength(paramHandles));
+    slotFading.fill(false); // Nothing played yet, the first block doesn't need to fade elements in
+    telemetry.setBlockInfo(sampleRate, samplesPerBlock);
+    silentSamples = 0;
+    isSleeping = false;
+
+    preparedSampleRate = sampleRate;
+    preparePool->addJob(prepareJob.get(), false);
 }
 
 void Tutorial_EQAudioProcessor::releaseResources()
@@ -144,6 +387,14 @@ bool Tutorial_EQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // The sidechain can be off, mono or stereo, whatever the main bus is
+    if (layouts.inputBuses.size() > 1) {
+        const auto sidechain = layouts.getChannelSet(true, 1);
+        if (!sidechain.isDisabled() && sidechain != juce::AudioChannelSet::mono()
+            && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -153,7 +404,10 @@ bool Tutorial_EQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
 
 void Tutorial_EQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    EQ_TRACE_SCOPE("processBlock");
     juce::ScopedNoDenormals noDenormals;
+    StageTimer stageTimer(telemetry); // Whatever follows the last lap, early returns included, is chain processing
+    CpuGovernor::ScopedBlock governed(governor, telemetry, buffer.getNumSamples());
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -166,6 +420,17 @@ void Tutorial_EQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
+    const int numSamples = buffer.getNumSamples();
+
+    // Re-blocking: a short call in steady state only runs the chains, the control work below waits for the
+    // control period to be over. Params changed meanwhile are picked up then
+    if (reblockStep > 0 && numSamples < controlPeriod && samplesSinceControl < controlPeriod && CanSkipControl(buffer)) {
+        samplesSinceControl += numSamples;
+        ProcessShortCall(buffer);
+        return;
+    }
+    samplesSinceControl = 0;
+
     // This is the place where you'd normally do the guts of your plugin's
     // audio processing...
     // Make sure to reset the state if your inner loop is processing
@@ -177,23 +442,227 @@ void Tutorial_EQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     
     // Update the parameters before processing
     // ======
-    UpdateFilters();
-    
+    const auto programVersion = programParamsVersion.load();
+    const auto chainSettings = getChainSettings(paramHandles);
+    // Switched to linear phase while playing: minimum phase until the background job has built the engine
+    const bool isLinearPhase = IsLinearPhase(paramHandles) && isLinearPhaseReady.load(std::memory_order_acquire);
+    if (IsLinearPhase(paramHandles) && !isLinearPhase) {
+        triggerAsyncUpdate(); // Queues the job, see handleAsyncUpdate
+    }
+    const int firLength = GetFirLength(paramHandles);
+    const bool isDynamicPeak = IsDynamicPeak(paramHandles) && !isLinearPhase; // The FIR can't follow an envelope
+    const bool detectSidechain = static_cast<int>(paramHandles[DynDetector]->load()) == DetectSidechain;
+    stageTimer.lap(TelemetryStage::ParamRead);
+
+    // Decided by the previous blocks' timing. Offline, the render waits for us: full quality whatever the load
+    governor.setEnabled(IsGovernorOn(paramHandles) && !isNonRealtime());
+    const auto tier = governor.getTier();
+    if (tier != appliedTier) {
+        ApplyQualityTier(tier);
+    }
+
+    // The host must know about the FIR's delay, it compensates the other tracks with it
+    const int latency = isLinearPhase ? linearPhase->getLatencyForLength(firLength) : 0;
+    if (latency != targetLatency) {
+        targetLatency = latency;
+        triggerAsyncUpdate();
+    }
+
+    // While setCurrentProgram sets them, the params are half old, half new: wait for the next block
+    const bool programParamsSettled = (programVersion & 1) == 0 && programVersion == programParamsVersion.load();
+
+    // Program changes only flip to coefficients designed in the background, they stay pending until then
+    const int programToLoad = programParamsSettled && programCoefs.load(std::memory_order_acquire) != nullptr
+        ? pendingProgram.exchange(-1) : -1;
+    if (programToLoad >= 0) {
+        StartProgramChange(programToLoad, chainSettings, isLinearPhase);
+    }
+
+    // Only redesign when something changed, this also keeps the tail up to date
+    const bool bandsChanged = ApplyBandParams();
+    bool settingsChanged = programParamsSettled && chainSettings != appliedSettings;
+    samplesSinceDesign = juce::jmin(samplesSinceDesign + numSamples, MaxDecaySamples);
+    if (appliedTier >= QualityTier::CoarseUpdates && samplesSinceDesign < getSampleRate() * GovernorConfig::CoarseUpdateSeconds) {
+        settingsChanged = false; // Picked up by a later block, the settings are compared again then
+    }
+
+    // Automation smoothing: the block ramps from the applied settings to the new ones, sub-block by sub-block.
+    // The first sub-block is designed here, like a whole block would be
+    const auto rampStart = appliedSettings;
+    const int numSubBlocks = settingsChanged && !isLinearPhase && !isProgramFading
+        ? juce::jmin(GetNumAutomationSubBlocks(numSamples, GetAutomationSmoothing(paramHandles)), GetMaxAutomationSubBlocks()) : 1;
+    if (filtersDirty.exchange(false) || bandsChanged || settingsChanged
+        || isLinearPhase != appliedLinearPhase || firLength != appliedFirLength) {
+        DesignFilters(numSubBlocks > 1 ? InterpolateSettings(rampStart, chainSettings, (float) (numSamples / numSubBlocks) / numSamples)
+                                       : chainSettings,
+                      isLinearPhase, firLength);
+    }
+
+    // Cheap: per block it only sets glide targets, the envelope moves the gain per sample
+    const bool dynamicChanged = dynamicPeak.setParameters(getDynamicBandSettings(paramHandles));
+    const int stereoMode = GetStereoMode(paramHandles);
+    if (!isLinearPhase && stereoMode != appliedStereoMode) {
+        SetStereoMode(stereoMode); // The FIR runs L/R, the mode applies once back to minimum phase
+    }
+    if (isDynamicPeak != appliedDynamicPeak) {
+        SetPeakMode(isDynamicPeak);
+    } else if (dynamicChanged && appliedDynamicPeak) {
+        UpdateTail(isLinearPhase, firLength);
+    }
+
+    // An engine switch waits for a block where it is the only crossfade, the old engine's pass must not take any other
+    const int engine = GetChainEngine(paramHandles);
+    bool canSwitchEngine = !isLinearPhase && numSubBlocks == 1 && !stereoModeFading && !isProgramFading && !peakModeFading;
+    for (auto fading : slotFading) {
+        canSwitchEngine = canSwitchEngine && !fading;
+    }
+    if (engine != chainEngine && canSwitchEngine) {
+        SetChainEngine(engine);
+    }
+    // Only splits the next blocks differently, same states
+    if (IsReblocking(paramHandles) != appliedReblocking) {
+        appliedReblocking = !appliedReblocking;
+        UpdateReblockStep();
+    }
+    stageTimer.lap(TelemetryStage::CoefUpdate);
+
+    // Silence detection
+    // ======
+
+    if (IsBlockSilent(buffer, totalNumInputChannels)) {
+        silentSamples = juce::jmin(silentSamples + numSamples, MaxDecaySamples + numSamples);
+        if (silentSamples > tailSamples) {
+            // The tail has decayed under SilenceFloor: output zeros without running anything
+            if (!isSleeping) {
+                ResetChain(*LChain);
+                ResetChain(*RChain);
+                dynamicPeak.reset();
+                extraBands.reset();
+                if (isLinearPhaseReady.load(std::memory_order_acquire)) linearPhase->reset();
+                isSleeping = true;
+            }
+            buffer.clear();
+            return;
+        }
+    } else {
+        silentSamples = 0;
+        isSleeping = false;
+    }
+
+    // Every band is neutral: the output is the input, nothing to do in place
+    if (!isLinearPhase && !isProgramFading && numSubBlocks == 1 && IsChainIdentity() && !appliedDynamicPeak && !peakModeFading
+        && extraBands.getNumActiveBands() == 0) {
+        return;
+    }
+
     // Block processing
     // ======
 
-    juce::dsp::AudioBlock<float> block(buffer);
+    // NOTE: The buffer also holds the sidechain's channels, after the main bus'
+    juce::dsp::AudioBlock<float> fullBlock(buffer);
+    auto block = fullBlock.getSubsetChannelBlock(0, (size_t) juce::jmin(totalNumOutputChannels, buffer.getNumChannels()));
+
+    // No channel: the dynamic peak listens to its own input
+    juce::dsp::AudioBlock<float> detector;
+    if (detectSidechain && getBusCount(true) > 1 && getChannelCountOfBus(true, 1) > 0) {
+        detector = fullBlock.getSubsetChannelBlock((size_t) getChannelIndexInProcessBlockBuffer(true, 1, 0),
+                                                   (size_t) getChannelCountOfBus(true, 1));
+    }
+
+    if (isLinearPhase) {
+        // Kernel is redesigned in the background, the new one is crossfaded in by the convolution.
+        // NOTE: The extra bands are in the kernel, their biquads after it would make the output minimum phase again
+        linearPhase->setTarget(chainSettings, extraBands.getBands(), firLength);
+        linearPhase->process(juce::dsp::ProcessContextReplacing<float>(block));
+        return;
+    }
+
+    // A stereo mode switch: the old mode on a copy, the new one from cleared states in place, then crossfade
+    const bool fadeStereoMode = stereoModeFading && numSamples <= stereoModeScratch.getNumSamples();
+    if (fadeStereoMode) {
+        auto scratchBlock = juce::dsp::AudioBlock<float>(stereoModeScratch).getSubBlock(0, (size_t) numSamples);
+        scratchBlock.copyFrom(block);
+        ProcessStereoMode(previousStereoMode, scratchBlock, detector, rampStart, numSubBlocks);
+    }
+    if (stereoModeFading) {
+        ResetChain(*LChain);
+        ResetChain(*RChain);
+        dynamicPeak.reset();
+        stereoModeFading = false;
+        engineFading = false; // Every engine's states were just cleared, the mode's crossfade covers the switch too
+    }
+
+    // An engine switch: same scheme, nothing else is in transition. The dynamic band doesn't depend on the engine,
+    // both passes start from its states and the new one keeps them
+    const bool fadeEngine = engineFading && numSamples <= stereoModeScratch.getNumSamples();
+    if (fadeEngine) {
+        auto scratchBlock = juce::dsp::AudioBlock<float>(stereoModeScratch).getSubBlock(0, (size_t) numSamples);
+        scratchBlock.copyFrom(block);
+        const auto dynamicStates = dynamicPeak;
+        const int newEngine = chainEngine;
+        SelectEngine(previousEngine);
+        ProcessStereoMode(appliedStereoMode, scratchBlock, detector, rampStart, numSubBlocks);
+        SelectEngine(newEngine);
+        dynamicPeak = dynamicStates;
+    }
+    engineFading = false;
+    previousEngine = chainEngine;
+
+    // The old mode took the block's transitions, the new one fades in with the end result
+    ProcessStereoMode(appliedStereoMode, block, detector, rampStart, fadeStereoMode ? 1 : numSubBlocks);
+
+    if (fadeStereoMode || fadeEngine) {
+        for (int ch = 0; ch < 2; ch++) {
+            CrossfadeFromDry(block.getChannelPointer((size_t) ch), stereoModeScratch.getReadPointer(ch), numSamples, true);
+        }
+    }
+
+    extraBands.process(juce::dsp::ProcessContextReplacing<float>(block));
+}
+
+void Tutorial_EQAudioProcessor::ProcessStereoMode(int mode, juce::dsp::AudioBlock<float>& block,
+                                                  const juce::dsp::AudioBlock<float>& detector,
+                                                  const ChainSettings& rampStart, int numSubBlocks)
+{
+    if (mode != LeftRight) {
+        ProcessMidSide(mode == SideOnly, block, detector, rampStart, numSubBlocks);
+        return;
+    }
+
+    if (isProgramFading) {
+        ProcessProgramFade(block, detector);
+        return;
+    }
+
+    const int numSamples = (int) block.getNumSamples();
 
     // NOTE: We extract the 2 channels that were created as public members of our processor class
     auto left_block = block.getSingleChannelBlock(0);
     auto right_block = block.getSingleChannelBlock(1);
 
-    // NOTE: create contexts to provide wrappers around our blocks of data
-    juce::dsp::ProcessContextReplacing<float> leftContext(left_block);
-    juce::dsp::ProcessContextReplacing<float> rightContext(right_block);
+    // Dual mono: a mono source on a stereo track doesn't need RChain. The dynamic band has its own states, and
+    // its mode fade runs both chains, they keep the stereo path. So do blocks redesigned mid-way (automation smoothing)
+    const bool isIdentical = AreChannelsIdentical(left_block.getChannelPointer(0), right_block.getChannelPointer(0), numSamples);
+    const bool dualMono = isIdentical && !appliedDynamicPeak && !peakModeFading && numSubBlocks == 1
+        && (isDualMono || identicalSamples >= tailSamples);
+    identicalSamples = isIdentical ? juce::jmin(identicalSamples + numSamples, MaxDecaySamples) : 0;
+    if (dualMono) {
+        isDualMono = true;
+    } else {
+        LeaveDualMono();
+    }
+
+    if (numSubBlocks > 1) {
+        ProcessAutomationRamp(left_block, right_block, detector, rampStart, numSubBlocks);
+    } else if (reblockStep > 0 && !appliedDynamicPeak) {
+        ProcessReblocked(left_block, right_block, detector);
+    } else {
+        ProcessMonoChains(left_block, right_block, detector);
+    }
 
-    LChain.process(leftContext);
-    RChain.process(rightContext);
+    if (isDualMono) {
+        right_block.copyFrom(left_block);
+    }
 }
 
 //==============================================================================
@@ -229,151 +698,970 @@ void Tutorial_EQAudioProcessor::getStateInformation (juce::MemoryBlock& destData
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
 
-    // NOTE: this is all thats needed to save the plugin state!
+    // NOTE: No ValueTree, the values are written by index (see StateFormat). Way faster to load
     bool append = true;
     juce::MemoryOutputStream mos(destData, append);
-    apvts.state.writeToStream(mos);
+    mos.writeInt((int) StateFormat::Magic);
+    mos.writeShort((short) StateFormat::Version);
+    mos.writeShort((short) NumParams);
+    for (auto* handle : paramHandles) {
+        mos.writeFloat(handle->load());
+    }
+
+    mos.writeShort((short) (MultiBandEQ::MaxBands * NumBandParams));
+    for (const auto& band : bandParamHandles) {
+        for (auto* handle : band) {
+            mos.writeFloat(handle->load());
+        }
+    }
+
+    mos.writeInt(currentProgram);
 }
 
 void Tutorial_EQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    EQ_TRACE_SCOPE("setStateInformation");
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
 
-    auto newTree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if (newTree.isValid()) {
+    if (!ReadBinaryState(data, sizeInBytes)) {
+        // States saved before the binary format
+        auto newTree = juce::ValueTree::readFromData(data, sizeInBytes);
+        if (!newTree.isValid()) return;
         apvts.replaceState(newTree);
-        UpdateFilters();
     }
+
+    // NOTE: Only flags the redesign, the audio thread does it on its next block, so restoring returns right away
+    UpdateFilters();
+}
+
+void Tutorial_EQAudioProcessor::SetParamValue(ParamIdx idx, float value)
+{
+    auto* param = paramObjects[idx];
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+bool Tutorial_EQAudioProcessor::ReadBinaryState(const void* data, int sizeInBytes)
+{
+    if (sizeInBytes < StateFormat::HeaderSize) return false;
+
+    juce::MemoryInputStream mis(data, (size_t) sizeInBytes, false);
+    if ((juce::uint32) mis.readInt() != StateFormat::Magic) return false;
+
+    const int version = mis.readShort();
+    const int numStored = mis.readShort();
+    jassert(version <= StateFormat::Version); // Saved by a newer build, its extra params are ignored
+
+    if (numStored < 0 || sizeInBytes < StateFormat::HeaderSize + numStored * (int) sizeof(float)) return false;
+
+    for (const auto& desc : ParamTable) {
+        // Params added after the state was saved get their default
+        SetParamValue(desc.idx, desc.idx < numStored ? mis.readFloat() : desc.dflt);
+    }
+    for (int i = (int) ParamTable.size(); i < numStored; i++) {
+        mis.readFloat(); // Saved by a newer build
+    }
+
+    // Bands, older states have none: they are all off
+    const int numBandValues = version >= StateFormat::FirstVersionWithBands && mis.getNumBytesRemaining() >= 2
+        ? mis.readShort() : 0;
+    const bool hasBands = numBandValues > 0 && mis.getNumBytesRemaining() >= numBandValues * (juce::int64) sizeof(float);
+    for (int band = 0, i = 0; band < MultiBandEQ::MaxBands; band++) {
+        for (const auto& desc : BandParamTable) {
+            const float value = hasBands && i++ < numBandValues ? mis.readFloat() : desc.dflt;
+            auto* param = bandParamObjects[(size_t) band][desc.idx];
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+        }
+    }
+    for (int i = MultiBandEQ::MaxBands * NumBandParams; hasBands && i < numBandValues; i++) {
+        mis.readFloat(); // Saved by a newer build
+    }
+
+    // Only what the host shows, the params already hold the program's values (or the user's edits of them)
+    const bool hasProgram = version >= StateFormat::FirstVersionWithProgram && mis.getNumBytesRemaining() >= 4;
+    currentProgram = hasProgram ? juce::jlimit(0, getNumPrograms() - 1, mis.readInt()) : 0;
+    return true;
 }
 
 //==============================================================================
 // This creates new instances of the plugin..
+#if !TUTORIAL_EQ_MULTI_BUS // The Multi-Bus target's is in MultiBusEQ.cpp
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new Tutorial_EQAudioProcessor();
 }
+#endif
 
 //NOTE: rappel, & fait qu'on travaille direct sur l'objet, pas de copie, ni de pointeur
 // avantages to ptrs: null safety
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+ChainSettings getChainSettings(const ParamHandles& params)
 {
     ChainSettings settings;
 
-    // Option 1: ceci retourne une normalized value (0-1), so we dont want that
-    // apvts.getParameter("LowCut Freq")->getValue();
-    // Option 2: get raw value va donner notre range predetermined
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.hiCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGaindB = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQ = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.lowCutSlope = apvts.getRawParameterValue("LowCut Slope")->load();
-    settings.hiCutSlope = apvts.getRawParameterValue("HighCut Slope")->load();
+    // NOTE: raw values are in our predetermined range, not normalized (0-1)
+    settings.lowCutFreq = params[LowCutFreq]->load();
+    settings.hiCutFreq = params[HiCutFreq]->load();
+    settings.peakFreq = params[PeakFreq]->load();
+    settings.peakGaindB = params[PeakGain]->load();
+    settings.peakQ = params[PeakQuality]->load();
+    settings.lowCutSlope = static_cast<int>(params[LowCutSlope]->load());
+    settings.hiCutSlope = static_cast<int>(params[HiCutSlope]->load());
+    settings.designMode = static_cast<int>(params[DesignMode]->load());
 
     return settings;
 }
 
-/* static */ juce::AudioProcessorValueTreeState::ParameterLayout Tutorial_EQAudioProcessor::createParamLayout()
+juce::MemoryBlock MakeStateFromSettings(const ChainSettings& cs)
+{
+    std::array<float, NumParams> values {};
+    for (const auto& desc : ParamTable) {
+        values[desc.idx] = desc.dflt;
+    }
+    values[LowCutFreq] = cs.lowCutFreq;
+    values[HiCutFreq] = cs.hiCutFreq;
+    values[PeakFreq] = cs.peakFreq;
+    values[PeakGain] = cs.peakGaindB;
+    values[PeakQuality] = cs.peakQ;
+    values[LowCutSlope] = static_cast<float>(cs.lowCutSlope);
+    values[HiCutSlope] = static_cast<float>(cs.hiCutSlope);
+    values[DesignMode] = static_cast<float>(cs.designMode);
+
+    // Same layout as getStateInformation
+    juce::MemoryBlock state;
+    {
+        juce::MemoryOutputStream mos(state, false); // Only written through once it goes out of scope
+        mos.writeInt((int) StateFormat::Magic);
+        mos.writeShort((short) StateFormat::Version);
+        mos.writeShort((short) NumParams);
+        for (float value : values) {
+            mos.writeFloat(value);
+        }
+
+        // Every band off
+        mos.writeShort((short) (MultiBandEQ::MaxBands * NumBandParams));
+        for (int band = 0; band < MultiBandEQ::MaxBands; band++) {
+            for (const auto& desc : BandParamTable) {
+                mos.writeFloat(desc.dflt);
+            }
+        }
+
+        mos.writeInt(0); // Not a factory program, the first one is shown
+    }
+    return state;
+}
+
+BandSettings getBandSettings(const BandParamHandles& params, int bandIdx)
+{
+    const auto& handles = params[(size_t) bandIdx];
+    const int typeChoice = static_cast<int>(handles[BandTypeParam]->load());
+
+    BandSettings band;
+    band.active = typeChoice > 0; // Off is the first choice
+    band.type = static_cast<BandType>(juce::jmax(0, typeChoice - 1));
+    band.freq = handles[BandFreqParam]->load();
+    band.gaindB = handles[BandGainParam]->load();
+    band.q = handles[BandQualityParam]->load();
+    return band;
+}
+
+DynamicBandSettings getDynamicBandSettings(const ParamHandles& params)
 {
-    const float earMinFreq = 20.f;
-    const float earMaxFreq = 20000.f;
-    const float skewLogFreqRange = 0.25f; // Allows having 10kHz at 90% of the knob (log scale for hi and lo freqs)
+    DynamicBandSettings settings;
 
+    settings.freq = params[PeakFreq]->load();
+    settings.gaindB = params[PeakGain]->load();
+    settings.q = params[PeakQuality]->load();
+    settings.thresholddB = params[DynThreshold]->load();
+    settings.ratio = params[DynRatio]->load();
+    settings.rangedB = params[DynRange]->load();
+    settings.attackMs = params[DynAttack]->load();
+    settings.releaseMs = params[DynRelease]->load();
+
+    return settings;
+}
+
+/* static */ juce::AudioProcessorValueTreeState::ParameterLayout Tutorial_EQAudioProcessor::createParamLayout()
+{
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    juce::SharedResourcePointer<SharedResources> shared; // IDs and labels are built once per process
 
     // We want unique pointers for parameters
     // make_unique uses new implicitly and initializes a std::unique_ptr (dynamic)
+    // NOTE: Skewfactor permet de setup logaritmiquement. 1 est aucun skew
+    for (const auto& desc : ParamTable) {
+        const auto& id = shared->getParamId(desc.idx);
+        if (desc.isChoice()) {
+            // e.g. to set the HC / LC filter steepness, we use predetermined options (choices)
+            layout.add(std::make_unique<juce::AudioParameterChoice>(id, id,
+                shared->getChoiceLabels(desc.idx), static_cast<int>(desc.dflt)));
+        } else {
+            layout.add(std::make_unique<juce::AudioParameterFloat>(
+                id, id,
+                juce::NormalisableRange<float>(desc.minVal, desc.maxVal, desc.interval, desc.skew), desc.dflt));
+        }
+    }
+
+    // The N-band engine's bands, band after band
+    for (int band = 0; band < MultiBandEQ::MaxBands; band++) {
+        for (const auto& desc : BandParamTable) {
+            const auto& id = shared->getBandParamId(band, desc.idx);
+            if (desc.isChoice()) {
+                layout.add(std::make_unique<juce::AudioParameterChoice>(id, id,
+                    shared->getBandTypeLabels(), static_cast<int>(desc.dflt)));
+            } else {
+                layout.add(std::make_unique<juce::AudioParameterFloat>(
+                    id, id,
+                    juce::NormalisableRange<float>(desc.minVal, desc.maxVal, desc.interval, desc.skew), desc.dflt));
+            }
+        }
+    }
+
+    return layout;
+}
 
-    //======================
 
-    // TODO: Change the 3 freq params for less redundance
-    // Helper function to create an AudioParameterFloat
-    /* auto makeParam = [earMinFreq, earMaxFreq](const juce::String& paramID, const juce::String& paramName, float defaultValue) {
-        return std::make_unique<juce::AudioParameterFloat>(
-            paramID, paramName,
-            juce::NormalisableRange<float>(earMinFreq, earMaxFreq, 1.f, 1.f),
-            defaultValue);
+void Tutorial_EQAudioProcessor::setExtraBand(int bandIdx, const BandSettings& band)
+{
+    jassert(juce::isPositiveAndBelow(bandIdx, MultiBandEQ::MaxBands));
+
+    auto setParam = [this, bandIdx](BandParamIdx idx, float value) {
+        auto* param = bandParamObjects[(size_t) bandIdx][idx];
+        param->setValueNotifyingHost(param->convertTo0to1(value));
     };
-    layout.add(makeParam("LowCut Freq", "LowCut Freq", earMinFreq));
-    layout.add(makeParam("HighCut Freq", "HighCut Freq", earMaxFreq));
-    layout.add(makeParam("Peak Freq", "Peak Freq", 750.f));
-    */
-
-    // layout.add(std::make_unique<juce::AudioParameterFloat(const String &paramID,
-    //     const String &paramName, NormalisableRange<float) normRng, float dflt);
-    // Le range est de 20 - 20kHz (human ear)
-    // juce::NormalisableRange<float>(earMinFreq, earMaxFreq, 1.f, ValueType skewFactor)
-    // -> Skewfactor permet de setup logaritmiquement. Ici, 1 est aucun skew
-    // float dflt -> Set to 20 cuz we dont want to low cut by default
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        "LowCut Freq", "LowCut Freq",
-        juce::NormalisableRange<float>(earMinFreq, earMaxFreq, 1.f, skewLogFreqRange), earMinFreq));
-
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        "HighCut Freq", "HighCut Freq",
-        juce::NormalisableRange<float>(earMinFreq, earMaxFreq, 1.f, skewLogFreqRange), earMaxFreq));
-
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        "Peak Freq", "Peak Freq",
-        juce::NormalisableRange<float>(earMinFreq, earMaxFreq, 1.f, skewLogFreqRange), 750.f));
-
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        "Peak Gain", "Peak Gain",
-        juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.0f));
-    
-    // Quality refers to Q (a large Q will make a narrow notch filter)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        "Peak Quality", "Peak Quality",
-        juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
-    
-    // To set the HC / LC filter steepness, we use predetermined options (choices)
-    juce::StringArray strs;
-    for (int i = 1; i <= 4; i++) {
-        juce::String str;
-        str << i*12 << "dB/Oct";
-        strs.add(str);
-    }
-    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope",
-        strs, 0)); // Defaults to idx 0
-    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope",
-        strs, 0)); // Defaults to idx 0
+    setParam(BandTypeParam, band.active ? (float) band.type + 1.f : 0.f);
+    setParam(BandFreqParam, band.freq);
+    setParam(BandGainParam, band.gaindB);
+    setParam(BandQualityParam, band.q);
+}
 
-    return layout;
+void Tutorial_EQAudioProcessor::setAutomationSmoothing(int minSubBlockSamples)
+{
+    const auto* found = std::find(std::begin(AutomationSmoothingSamples), std::end(AutomationSmoothingSamples), minSubBlockSamples);
+    jassert(found != std::end(AutomationSmoothingSamples)); // Not a length the param offers
+    if (found == std::end(AutomationSmoothingSamples)) return;
+
+    SetParamValue(AutomationSmoothing, (float) std::distance(std::begin(AutomationSmoothingSamples), found));
+}
+
+/* static */ juce::String Tutorial_EQAudioProcessor::GetBandParamId(int bandIdx, BandParamIdx idx)
+{
+    return "Band " + juce::String(bandIdx + 1) + " " + BandParamTable[idx].name;
 }
 
 
 // Private
 
-void Tutorial_EQAudioProcessor::UpdatePeakFilter(const ChainSettings& chainSettings)
+void Tutorial_EQAudioProcessor::handleAsyncUpdate()
 {
-    auto newPeakCoefs = MakePeakFilter(chainSettings, getSampleRate());
+    setLatencySamples(targetLatency);
+    FreeRetiredCoefs();
 
-    // NOTE: Pass directly so there is no copy in a variable
-    UpdateCoefficients(LChain.get<MonoChainIdx::Peak>().coefficients, newPeakCoefs);
-    UpdateCoefficients(RChain.get<MonoChainIdx::Peak>().coefficients, newPeakCoefs);
+    // A job queued or running may already be past the linear phase: the audio thread asks again next block
+    if (IsLinearPhase(paramHandles) && !isLinearPhaseReady.load(std::memory_order_acquire)
+        && !preparePool->contains(prepareJob.get())) {
+        preparePool->addJob(prepareJob.get(), false);
+    }
 }
 
-void Tutorial_EQAudioProcessor::UpdateCutFilters(const ChainSettings& chainSettings)
+void Tutorial_EQAudioProcessor::SwapChainCoefs(MonoChain& chain, const ChainCoefs& coefs, const ChainSettings& cs)
 {
-    
-    // Cut filters
-    // Low cut    
-    auto newlowCutCoefs = MakeLowCutFilter(chainSettings, getSampleRate());
-    auto& leftLowCut = LChain.get<MonoChainIdx::LowCut>();
-    auto& rightLowCut = RChain.get<MonoChainIdx::LowCut>();
+    RetireCoefs(chain.get<MonoChainIdx::Peak>().coefficients);
+    for (auto* cut : { &chain.get<MonoChainIdx::LowCut>(), &chain.get<MonoChainIdx::HiCut>() }) {
+        RetireCoefs(cut->get<0>().coefficients);
+        RetireCoefs(cut->get<1>().coefficients);
+        RetireCoefs(cut->get<2>().coefficients);
+        RetireCoefs(cut->get<3>().coefficients);
+    }
+    ApplyChainCoefs(chain, coefs, cs);
+    triggerAsyncUpdate();
+}
 
-    UpdateCutFilter(leftLowCut, newlowCutCoefs, chainSettings.lowCutSlope);
-    UpdateCutFilter(rightLowCut, newlowCutCoefs, chainSettings.lowCutSlope);
+void Tutorial_EQAudioProcessor::RetireCoefs(const Coefs& coefs)
+{
+    // Another holder (the other chain, a program) frees it later, or keeps it
+    if (coefs == nullptr || coefs->getReferenceCount() > 1) return;
 
+    const auto scope = retiredCoefsFifo.write(1);
+    if (scope.blockSize1 + scope.blockSize2 == 0) {
+        jassertfalse; // The message thread is stalled, this one will be freed here
+        return;
+    }
+    retiredCoefs[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = coefs;
+}
 
-    // High cut
-    auto newhiCutCoefs = MakeHighCutFilter(chainSettings, getSampleRate());
-    auto& lefthiCut = LChain.get<MonoChainIdx::HiCut>();
-    auto& righthiCut = RChain.get<MonoChainIdx::HiCut>();
+void Tutorial_EQAudioProcessor::FreeRetiredCoefs()
+{
+    const juce::ScopedLock sl(retiredCoefsLock);
+    const auto scope = retiredCoefsFifo.read(retiredCoefsFifo.getNumReady());
+    scope.forEach([this](int idx) { retiredCoefs[(size_t) idx] = nullptr; });
+}
 
-    // The filter algo returns coeficients, we pass them to the chain to be applied on audio signal
-    UpdateCutFilter(lefthiCut, newhiCutCoefs, chainSettings.hiCutSlope);
-    UpdateCutFilter(righthiCut, newhiCutCoefs, chainSettings.hiCutSlope);
+void Tutorial_EQAudioProcessor::ResizeRetiredCoefs(int samplesPerBlock)
+{
+    // Every sub-block of the shortest smoothing length redesigns both chains and retires one chain's worth
+    const int maxSubBlocks = GetNumAutomationSubBlocks(samplesPerBlock, AutomationSmoothingSamples[1]);
+    const int capacity = juce::jmax(MinRetiredCoefsCapacity, maxSubBlocks * CoefsPerChain * RetiredCoefsBlocks);
+
+    FreeRetiredCoefs();
+    const juce::ScopedLock sl(retiredCoefsLock);
+    if (capacity != retiredCoefsFifo.getTotalSize()) {
+        retiredCoefs.assign((size_t) capacity, nullptr);
+        retiredCoefsFifo.setTotalSize(capacity);
+    }
+}
 
-}
\ No newline at end of file
+void Tutorial_EQAudioProcessor::PrepareInBackground()
+{
+    // NOTE: Only this job and prepareToPlay (which waits for it first) create the engine, the audio thread
+    // touches it once isLinearPhaseReady is set
+    if (IsLinearPhase(paramHandles) && linearPhase == nullptr && linearPhaseSpec.sampleRate > 0.0) {
+        auto engine = std::make_unique<LinearPhaseEQ>();
+        engine->prepare(linearPhaseSpec, getChainSettings(paramHandles), GetExtraBandSettings(), GetFirLength(paramHandles),
+                        false); // Cold: designs
+        linearPhase = std::move(engine);
+        isLinearPhaseReady.store(true, std::memory_order_release);
+    }
+
+    // Warm start: a rate already prepared (by us or another instance) is only a map lookup
+    if (programCoefs.load(std::memory_order_acquire) == nullptr) {
+        programCoefsOwner = sharedResources->getProgramCoefs(preparedSampleRate, [](double sr) {
+            std::vector<ChainCoefs> coefs;
+            for (const auto& program : FactoryPrograms) {
+                coefs.push_back(MakeChainCoefs(program.settings, sr));
+            }
+            return coefs;
+        });
+        programCoefs.store(programCoefsOwner.get(), std::memory_order_release);
+    }
+}
+
+void Tutorial_EQAudioProcessor::waitForBackgroundPreparation()
+{
+    preparePool->waitForJobToFinish(prepareJob.get(), -1);
+}
+
+void Tutorial_EQAudioProcessor::CancelBackgroundPreparation()
+{
+    // NOTE: Not interruptible, but a job is a few ms at worst
+    preparePool->removeJob(prepareJob.get(), true, -1);
+}
+
+bool Tutorial_EQAudioProcessor::ApplyBandParams()
+{
+    // NOTE: 96 atomic reads, only the bands that moved are redesigned (setBand doesn't allocate)
+    bool changed = false;
+    for (int i = 0; i < MultiBandEQ::MaxBands; i++) {
+        const auto band = getBandSettings(bandParamHandles, i);
+        if (band != extraBands.getBand(i)) {
+            extraBands.setBand(i, band);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+ExtraBandSettings Tutorial_EQAudioProcessor::GetExtraBandSettings() const
+{
+    ExtraBandSettings bands;
+    for (int i = 0; i < MultiBandEQ::MaxBands; i++) {
+        bands[(size_t) i] = getBandSettings(bandParamHandles, i);
+    }
+    return bands;
+}
+
+void Tutorial_EQAudioProcessor::DesignFilters(const ChainSettings& cs, bool isLinearPhase, int firLength)
+{
+    EQ_TRACE_SCOPE("UpdateFilters"); // The redesign UpdateFilters() asks for
+    // In linear phase the MonoChains don't run, they are redesigned when switching back
+    if (!isLinearPhase) {
+        const auto coefs = MakeChainCoefs(cs, getSampleRate());
+        SwapChainCoefs(*LChain, coefs, cs);
+        SwapChainCoefs(*RChain, coefs, cs);
+    }
+
+    UpdateNeutralBands(cs);
+
+    appliedSettings = cs;
+    appliedLinearPhase = isLinearPhase;
+    appliedFirLength = firLength;
+    samplesSinceDesign = 0;
+
+    UpdateTail(isLinearPhase, firLength);
+}
+
+void Tutorial_EQAudioProcessor::ProcessMonoChains(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                                                  const juce::dsp::AudioBlock<float>& detector)
+{
+    // Nothing fading: the whole chain in one call, so the cascade kernel gets every playing section at once
+    bool isSteady = !appliedDynamicPeak && !peakModeFading;
+    for (auto fading : slotFading) {
+        isSteady = isSteady && !fading;
+    }
+    if (isSteady && GetEngineLookAhead(chainEngine) == 1) {
+        ProcessChain(*LChain, leftBlock);
+        if (!isDualMono) ProcessChain(*RChain, rightBlock);
+        return;
+    }
+
+    // NOTE: Same order as MonoChain, element by element so neutral ones are skipped and transitions crossfaded
+    ProcessSlot<MonoChainIdx::LowCut>(leftBlock, rightBlock);
+    ProcessPeak(leftBlock, rightBlock, detector);
+    ProcessSlot<MonoChainIdx::HiCut>(leftBlock, rightBlock);
+}
+
+ChainSettings Tutorial_EQAudioProcessor::InterpolateSettings(const ChainSettings& from, const ChainSettings& to, float fraction) const
+{
+    if (fraction >= 1.f) return to; // Exactly, or the next block would see a change and redesign again
+
+    auto lerp = [this, fraction](ParamIdx idx, float fromValue, float toValue) {
+        const auto* param = paramObjects[idx];
+        const float from0to1 = param->convertTo0to1(fromValue);
+        return param->convertFrom0to1(from0to1 + fraction * (param->convertTo0to1(toValue) - from0to1));
+    };
+
+    auto cs = to;
+    cs.lowCutFreq = lerp(LowCutFreq, from.lowCutFreq, to.lowCutFreq);
+    cs.hiCutFreq = lerp(HiCutFreq, from.hiCutFreq, to.hiCutFreq);
+    cs.peakFreq = lerp(PeakFreq, from.peakFreq, to.peakFreq);
+    cs.peakGaindB = lerp(PeakGain, from.peakGaindB, to.peakGaindB);
+    cs.peakQ = lerp(PeakQuality, from.peakQ, to.peakQ);
+    return cs;
+}
+
+void Tutorial_EQAudioProcessor::ProcessAutomationRamp(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                                                      const juce::dsp::AudioBlock<float>& detector, const ChainSettings& rampStart,
+                                                      int numSubBlocks)
+{
+    /* Per-block ramp smoothing, not sample accurate automation. JUCE's wrappers hand over one value per param and block
+    (the VST3 one keeps the last point of each queue, AU and AAX set the params before the block), so where in the block
+    the host moved a param is lost. The block ramps in a straight line across its whole length, from where the previous
+    block ended to that value, redesigned at every sub-block: the step between blocks becomes a ramp, a late change
+    point still starts ramping at the block's first sample. A param set while the block runs (another thread, the
+    editor) bends the line from the next sub-block on */
+    const int numSamples = (int) leftBlock.getNumSamples();
+    const bool hasDetector = detector.getNumChannels() > 0;
+
+    for (int i = 0, start = 0; i < numSubBlocks; i++) {
+        const int end = numSamples * (i + 1) / numSubBlocks;
+        if (i > 0) {
+            const auto cs = InterpolateSettings(rampStart, getChainSettings(paramHandles), (float) end / numSamples);
+            if (cs != appliedSettings) {
+                DesignFilters(cs, false, appliedFirLength);
+            }
+        }
+
+        auto left = leftBlock.getSubBlock((size_t) start, (size_t) (end - start));
+        auto right = rightBlock.getSubBlock((size_t) start, (size_t) (end - start));
+        const auto subDetector = hasDetector ? detector.getSubBlock((size_t) start, (size_t) (end - start)) : detector;
+        ProcessMonoChains(left, right, subDetector);
+        start = end;
+    }
+}
+
+bool Tutorial_EQAudioProcessor::CanSkipControl(const juce::AudioBuffer<float>& buffer) const
+{
+    if (buffer.getNumChannels() < 2 || appliedStereoMode != LeftRight || stereoModeFading || engineFading || appliedLinearPhase
+        || isProgramFading || pendingProgram.load() >= 0 || appliedDynamicPeak || peakModeFading || isSleeping || filtersDirty.load()
+        || extraBands.getNumActiveBands() > 0) {
+        return false;
+    }
+    for (auto fading : slotFading) {
+        if (fading) return false;
+    }
+
+    // Dual mono must leave as soon as the channels differ, RChain takes LChain's states then
+    const int numSamples = buffer.getNumSamples();
+    return !isDualMono || AreChannelsIdentical(buffer.getReadPointer(0), buffer.getReadPointer(1), numSamples);
+}
+
+void Tutorial_EQAudioProcessor::ProcessShortCall(juce::AudioBuffer<float>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+    float* left = buffer.getWritePointer(0);
+
+    if (isDualMono) {
+        ProcessChainSamples(*LChain, left, numSamples);
+        juce::FloatVectorOperations::copy(buffer.getWritePointer(1), left, numSamples);
+    } else {
+        ProcessChainSamples(*LChain, left, numSamples);
+        ProcessChainSamples(*RChain, buffer.getWritePointer(1), numSamples);
+    }
+}
+
+void Tutorial_EQAudioProcessor::ProcessReblocked(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                                                 const juce::dsp::AudioBlock<float>& detector)
+{
+    const int numSamples = (int) leftBlock.getNumSamples();
+    const int body = numSamples - numSamples % reblockStep;
+    if (body == 0) {
+        ProcessMonoChains(leftBlock, rightBlock, detector);
+        return;
+    }
+
+    // NOTE: Hosts may hand over channels at any address. The body runs on an aligned copy then, larger blocks than
+    // announced in prepareToPlay run in place
+    float* host[] { leftBlock.getChannelPointer(0), rightBlock.getChannelPointer(0) };
+    float* aligned[] { host[0], host[1] };
+    for (size_t ch = 0; ch < 2; ch++) {
+        if (juce::snapPointerToAlignment(host[ch], ReblockAlignment) != host[ch] && body <= (int) reblockScratch.getNumSamples()) {
+            aligned[ch] = reblockScratch.getChannelPointer(ch);
+            juce::FloatVectorOperations::copy(aligned[ch], host[ch], body);
+        }
+    }
+
+    juce::dsp::AudioBlock<float> left(&aligned[0], 1, (size_t) body);
+    juce::dsp::AudioBlock<float> right(&aligned[1], 1, (size_t) body);
+    const auto bodyDetector = detector.getNumChannels() > 0 ? detector.getSubBlock(0, (size_t) body) : detector;
+    ProcessMonoChains(left, right, bodyDetector);
+
+    for (size_t ch = 0; ch < 2; ch++) {
+        if (aligned[ch] != host[ch]) juce::FloatVectorOperations::copy(host[ch], aligned[ch], body);
+    }
+
+    // Remainder: shorter than a step, sample by sample on the same states. The body left no fade running
+    const int tail = numSamples - body;
+    ProcessChainSamples(*LChain, host[0] + body, tail);
+    if (!isDualMono) ProcessChainSamples(*RChain, host[1] + body, tail);
+}
+
+void Tutorial_EQAudioProcessor::ApplyQualityTier(QualityTier tier)
+{
+    const bool wasSkipping = appliedTier >= QualityTier::SkipNearNeutral;
+    appliedTier = tier;
+
+    dynamicPeak.setControlInterval(tier >= QualityTier::ControlRateModulation ? GovernorConfig::ControlInterval : 1);
+    if (wasSkipping != (tier >= QualityTier::SkipNearNeutral)) {
+        UpdateFilters(); // The chain's and extra bands are re-analysed with the other threshold on the next block
+    }
+}
+
+void Tutorial_EQAudioProcessor::setNeutralThresholdDb(float thresholdDb)
+{
+    neutralThresholdDb = thresholdDb;
+    UpdateFilters(); // The chain's and extra bands are re-analysed on the next block, see UpdateNeutralBands
+}
+
+void Tutorial_EQAudioProcessor::UpdateNeutralBands(const ChainSettings& cs)
+{
+    // Under load, the governor also skips bands that are only nearly flat
+    const float threshold = appliedTier >= QualityTier::SkipNearNeutral
+        ? juce::jmax(neutralThresholdDb.load(), GovernorConfig::NearNeutralDb)
+        : neutralThresholdDb.load();
+    const double sampleRate = getSampleRate();
+    extraBands.setNeutralThreshold(threshold); // Re-classifies every extra band when it changed
+
+    auto deviationDb = [](double mag) { return std::abs(juce::Decibels::gainToDecibels(mag)); };
+
+    // Worst deviation over 20Hz-20kHz. A peak filter's is its gain, reached at its centre freq.
+    // Butterworth cuts are monotonic, so theirs is at the edge of the range they attenuate
+    const bool peakNeutral = std::abs(cs.peakGaindB) <= threshold;
+
+    const double lowEdge = ParamRanges::earMinFreq;
+    const double highEdge = juce::jmin((double) ParamRanges::earMaxFreq, sampleRate * 0.49);
+    const double lowCutDev = deviationDb(GetCutFilterMagnitudeForFrequency(LChain->get<MonoChainIdx::LowCut>(), lowEdge, sampleRate));
+    const double hiCutDev = deviationDb(GetCutFilterMagnitudeForFrequency(LChain->get<MonoChainIdx::HiCut>(), highEdge, sampleRate));
+
+    // NOTE: The default cuts, parked at the end of their range, still measure about -3dB at the edge, so they play
+    const bool lowCutNeutral = lowCutDev <= threshold;
+    const bool hiCutNeutral = hiCutDev <= threshold;
+
+    SetSlotActive<MonoChainIdx::LowCut>(!lowCutNeutral);
+    SetSlotActive<MonoChainIdx::Peak>(!peakNeutral);
+    SetSlotActive<MonoChainIdx::HiCut>(!hiCutNeutral);
+}
+
+template <int Idx>
+void Tutorial_EQAudioProcessor::SetSlotActive(bool isActive)
+{
+    const bool wasActive = !LChain->isBypassed<Idx>();
+    if (wasActive == isActive) return;
+
+    // Coming back: starts from cleared states, the fade in hides their transient
+    if (isActive) {
+        if (auto* blockChain = GetBlockChain(*LChain)) blockChain->resetElement<Idx>();
+        if (auto* blockChain = GetBlockChain(*RChain)) blockChain->resetElement<Idx>();
+    }
+    LChain->setBypassed<Idx>(!isActive);
+    RChain->setBypassed<Idx>(!isActive);
+    slotFading[Idx] = true;
+}
+
+template <int Idx>
+void Tutorial_EQAudioProcessor::ProcessSlot(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock)
+{
+    const bool isActive = !LChain->isBypassed<Idx>();
+    if (!isActive && !slotFading[Idx]) return;
+
+    const int numSamples = (int) leftBlock.getNumSamples();
+    // Larger blocks than announced in prepareToPlay switch instantly
+    const bool fade = slotFading[Idx] && numSamples <= (int) fadeScratch.size();
+
+    auto processChannel = [this, fade, isActive, numSamples](MonoChain& chain, juce::dsp::AudioBlock<float>& monoBlock) {
+        float* data = monoBlock.getChannelPointer(0);
+        if (fade) juce::FloatVectorOperations::copy(fadeScratch.data(), data, numSamples);
+
+        GetBlockChain(chain)->processElement<Idx>(chain, data, numSamples);
+
+        if (fade) CrossfadeFromDry(data, fadeScratch.data(), numSamples, isActive);
+    };
+
+    processChannel(*LChain, leftBlock);
+    if (!isDualMono) processChannel(*RChain, rightBlock); // Otherwise the left output is copied once the chain is done
+
+    slotFading[Idx] = false;
+}
+
+void Tutorial_EQAudioProcessor::SetPeakMode(bool isDynamic)
+{
+    LeaveDualMono();
+
+    // The mode taking over starts from cleared states, the fade hides their transient
+    if (isDynamic) {
+        dynamicPeak.reset();
+    } else {
+        if (auto* blockChain = GetBlockChain(*LChain)) blockChain->resetElement<MonoChainIdx::Peak>();
+        if (auto* blockChain = GetBlockChain(*RChain)) blockChain->resetElement<MonoChainIdx::Peak>();
+    }
+    appliedDynamicPeak = isDynamic;
+    peakModeFading = true;
+    UpdateTail(appliedLinearPhase, appliedFirLength);
+}
+
+void Tutorial_EQAudioProcessor::ProcessPeak(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                                            const juce::dsp::AudioBlock<float>& detector)
+{
+    const int numSamples = (int) leftBlock.getNumSamples();
+    const bool fade = peakModeFading && numSamples <= peakModeScratch.getNumSamples(); // Otherwise switches instantly
+    peakModeFading = false;
+
+    auto runMode = [this, &detector](bool isDynamic, juce::dsp::AudioBlock<float>& left, juce::dsp::AudioBlock<float>& right) {
+        if (isDynamic) ProcessDynamicPeak(left, right, detector);
+        else ProcessSlot<MonoChainIdx::Peak>(left, right);
+    };
+
+    if (!fade) {
+        runMode(appliedDynamicPeak, leftBlock, rightBlock);
+        return;
+    }
+
+    // Old mode on a copy, new one in place, then crossfade. The detector is read, never written, it can be run twice
+    auto scratchBlock = juce::dsp::AudioBlock<float>(peakModeScratch).getSubBlock(0, (size_t) numSamples);
+    auto oldLeft = scratchBlock.getSingleChannelBlock(0);
+    auto oldRight = scratchBlock.getSingleChannelBlock(1);
+    oldLeft.copyFrom(leftBlock);
+    oldRight.copyFrom(rightBlock);
+
+    runMode(!appliedDynamicPeak, oldLeft, oldRight);
+    runMode(appliedDynamicPeak, leftBlock, rightBlock);
+
+    CrossfadeFromDry(leftBlock.getChannelPointer(0), oldLeft.getChannelPointer(0), numSamples, true);
+    CrossfadeFromDry(rightBlock.getChannelPointer(0), oldRight.getChannelPointer(0), numSamples, true);
+}
+
+void Tutorial_EQAudioProcessor::ProcessDynamicPeak(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                                                   const juce::dsp::AudioBlock<float>& detector)
+{
+    float* channels[] { leftBlock.getChannelPointer(0), rightBlock.getChannelPointer(0) };
+    const float* detectorChannels[DynamicPeakBand::MaxChannels] {};
+    const int numDetectorChannels = juce::jmin((int) detector.getNumChannels(), DynamicPeakBand::MaxChannels);
+    for (int ch = 0; ch < numDetectorChannels; ch++) {
+        detectorChannels[ch] = detector.getChannelPointer((size_t) ch);
+    }
+
+    dynamicPeak.process(channels, 2, detectorChannels, numDetectorChannels, (int) leftBlock.getNumSamples());
+}
+
+void Tutorial_EQAudioProcessor::StartProgramChange(int index, const ChainSettings& paramSettings, bool isLinearPhase)
+{
+    const auto* programs = programCoefs.load(std::memory_order_acquire);
+    if (programs == nullptr || !juce::isPositiveAndBelow(index, (int) programs->size())) return;
+
+    LeaveDualMono(); // The fade runs the old RChain
+
+    const auto& cs = FactoryPrograms[(size_t) index].settings;
+    const auto& coefs = (*programs)[(size_t) index];
+    // The params were snapped to their intervals, so compare against them, not against the program.
+    // Its coefficients have its design though: another Filter Design param is redesigned next block
+    appliedSettings = paramSettings;
+    appliedSettings.designMode = cs.designMode;
+
+    if (isLinearPhase) {
+        // The MonoChains aren't playing, the convolution crossfades to the new kernel on its own
+        SwapChainCoefs(*LChain, coefs, cs);
+        SwapChainCoefs(*RChain, coefs, cs);
+        UpdateNeutralBands(cs);
+        UpdateTail(isLinearPhase, appliedFirLength);
+        return;
+    }
+
+    // Load the spare pair from cleared states, every element on. Neutral ones drop out once it plays
+    for (auto* spare : { &GetSpareChain(leftChains, LChain), &GetSpareChain(rightChains, RChain) }) {
+        SwapChainCoefs(*spare, coefs, cs);
+        ResetChain(*spare);
+        spare->setBypassed<MonoChainIdx::LowCut>(false);
+        spare->setBypassed<MonoChainIdx::Peak>(false);
+        spare->setBypassed<MonoChainIdx::HiCut>(false);
+    }
+    isProgramFading = true;
+    identicalSamples = 0; // The spare pair only converges from here
+}
+
+void Tutorial_EQAudioProcessor::ProcessProgramFade(juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& detector)
+{
+    const int numSamples = (int) block.getNumSamples();
+    const int numChannels = juce::jmin(2, (int) block.getNumChannels());
+    const bool canFade = numSamples <= programScratch.getNumSamples(); // Otherwise switches instantly
+
+    if (canFade) {
+        // Old program on a copy of the input...
+        auto scratchBlock = juce::dsp::AudioBlock<float>(programScratch).getSubBlock(0, (size_t) numSamples);
+        for (int ch = 0; ch < numChannels; ch++) {
+            juce::FloatVectorOperations::copy(programScratch.getWritePointer(ch), block.getChannelPointer((size_t) ch), numSamples);
+        }
+        auto oldLeft = scratchBlock.getSingleChannelBlock(0);
+        auto oldRight = scratchBlock.getSingleChannelBlock(1);
+        ProcessSlot<MonoChainIdx::LowCut>(oldLeft, oldRight);
+        // NOTE: The dynamic peak has one envelope, it only runs on the new program. The old one fades out without it
+        if (!appliedDynamicPeak) ProcessSlot<MonoChainIdx::Peak>(oldLeft, oldRight);
+        ProcessSlot<MonoChainIdx::HiCut>(oldLeft, oldRight);
+    }
+
+    // ...new one in place, then it becomes the playing pair
+    LChain = &GetSpareChain(leftChains, LChain);
+    RChain = &GetSpareChain(rightChains, RChain);
+    slotFading.fill(false);
+
+    auto leftBlock = block.getSingleChannelBlock(0);
+    auto rightBlock = block.getSingleChannelBlock(1);
+    if (appliedDynamicPeak) {
+        // Every element of the new pair is on, ProcessSlot runs them like ProcessChain would
+        ProcessSlot<MonoChainIdx::LowCut>(leftBlock, rightBlock);
+        ProcessDynamicPeak(leftBlock, rightBlock, detector);
+        ProcessSlot<MonoChainIdx::HiCut>(leftBlock, rightBlock);
+    } else {
+        ProcessChain(*LChain, leftBlock);
+        ProcessChain(*RChain, rightBlock);
+    }
+
+    if (canFade) {
+        for (int ch = 0; ch < numChannels; ch++) {
+            CrossfadeFromDry(block.getChannelPointer((size_t) ch), programScratch.getReadPointer(ch), numSamples, true);
+        }
+    }
+    isProgramFading = false;
+
+    UpdateNeutralBands(appliedSettings);
+    UpdateTail(false, appliedFirLength);
+}
+
+void Tutorial_EQAudioProcessor::SetStereoMode(int mode)
+{
+    LeaveDualMono(); // Only the stereo mode runs dual mono, RChain must be in sync for the fade's old mode
+    identicalSamples = 0;
+    previousStereoMode = appliedStereoMode;
+    appliedStereoMode = mode;
+    stereoModeFading = true; // Same chains, another signal: their states are cleared once the old mode ran
+}
+
+void Tutorial_EQAudioProcessor::ProcessMidSide(bool isSide, juce::dsp::AudioBlock<float>& block,
+                                               const juce::dsp::AudioBlock<float>& detector,
+                                               const ChainSettings& rampStart, int numSubBlocks)
+{
+    const int numSamples = (int) block.getNumSamples();
+    float* left = block.getChannelPointer(0);
+    float* right = block.getChannelPointer(1);
+
+    // NOTE: The block engines advance several samples per step, they can't be fused in a per sample loop
+    bool canFuse = GetEngineLookAhead(chainEngine) == 1 && !isProgramFading && numSubBlocks == 1 && !appliedDynamicPeak
+                   && !peakModeFading;
+    for (auto fading : slotFading) {
+        canFuse = canFuse && !fading;
+    }
+    if (canFuse) {
+        if (isSide) ProcessMidSideFused<true>(left, right, numSamples);
+        else ProcessMidSideFused<false>(left, right, numSamples);
+        return;
+    }
+
+    /* Transitions need the whole stereo code: the filtered path goes to both channels and runs through it, the other
+    one waits in midSideScratch. Only LChain's output is decoded, RChain processes a copy. Larger blocks than announced
+    in prepareToPlay go by chunks, the first one takes the transition */
+    const int chunkLength = juce::jmax(1, (int) midSideScratch.size());
+    for (int start = 0; start < numSamples;) {
+        const int n = juce::jmin(numSamples - start, chunkLength);
+        float* l = left + start;
+        float* r = right + start;
+        float* other = midSideScratch.data();
+
+        for (int i = 0; i < n; i++) {
+            const float mid = 0.5f * (l[i] + r[i]);
+            const float side = 0.5f * (l[i] - r[i]);
+            l[i] = r[i] = isSide ? side : mid;
+            other[i] = isSide ? mid : side;
+        }
+
+        auto chunk = block.getSubBlock((size_t) start, (size_t) n);
+        const auto chunkDetector = detector.getNumChannels() > 0 ? detector.getSubBlock((size_t) start, (size_t) n) : detector;
+        if (isProgramFading) {
+            ProcessProgramFade(chunk, chunkDetector);
+        } else {
+            auto leftChunk = chunk.getSingleChannelBlock(0);
+            auto rightChunk = chunk.getSingleChannelBlock(1);
+            if (numSubBlocks > 1 && start == 0) ProcessAutomationRamp(leftChunk, rightChunk, chunkDetector, rampStart, numSubBlocks);
+            else ProcessMonoChains(leftChunk, rightChunk, chunkDetector);
+        }
+
+        for (int i = 0; i < n; i++) {
+            const float mid = isSide ? other[i] : l[i];
+            const float side = isSide ? l[i] : other[i];
+            l[i] = mid + side;
+            r[i] = mid - side;
+        }
+        start += n;
+    }
+}
+
+template <bool IsSide>
+void Tutorial_EQAudioProcessor::ProcessMidSideFused(float* left, float* right, int numSamples)
+{
+    // LChain's playing sections. The other path's set is the identity: nothing to run
+    auto* blockChain = GetBlockChain(*LChain);
+    blockChain->beginSamples(*LChain);
+
+    // NOTE: One pass, each sample is read and written once. Separate encode, filter and decode passes would
+    // go over the block 3 times
+    for (int i = 0; i < numSamples; i++) {
+        float mid = 0.5f * (left[i] + right[i]);
+        float side = 0.5f * (left[i] - right[i]);
+
+        const float x = blockChain->processSample(IsSide ? side : mid);
+        if constexpr (IsSide) side = x;
+        else mid = x;
+
+        left[i] = mid + side;
+        right[i] = mid - side;
+    }
+
+    blockChain->endSamples();
+}
+
+BlockIIRChain* Tutorial_EQAudioProcessor::GetBlockChain(const MonoChain& chain)
+{
+    if (&chain == &leftChains[0]) return leftBlockChains[0].get();
+    if (&chain == &leftChains[1]) return leftBlockChains[1].get();
+    if (&chain == &rightChains[0]) return rightBlockChains[0].get();
+    jassert(&chain == &rightChains[1]);
+    return rightBlockChains[1].get();
+}
+
+void Tutorial_EQAudioProcessor::SelectEngine(int engine)
+{
+    chainEngine = engine;
+    // The scalar engine is the cascade of look ahead 1, through the plain loop
+    const auto kernel = engine == KernelCascade ? cascadeKernel : ProcessCascadeScalar;
+    for (auto* blockChains : { &leftBlockChains, &rightBlockChains }) {
+        for (auto& blockChain : *blockChains) {
+            blockChain->setLookAhead(GetEngineLookAhead(engine));
+            blockChain->setKernel(kernel);
+        }
+    }
+
+    UpdateReblockStep();
+}
+
+void Tutorial_EQAudioProcessor::UpdateReblockStep()
+{
+    // NOTE: The scalar and cascade engines advance one sample per step, any length and address suits them:
+    // re-blocking would only add aligned copies
+    const int lookAhead = GetEngineLookAhead(chainEngine);
+    reblockStep = appliedReblocking && lookAhead > 1 ? lookAhead : 0;
+    if (reblockStep > 0) {
+        controlPeriod = juce::jmax(reblockStep, juce::jmin(preparedBlockSize, MaxControlPeriod) / reblockStep * reblockStep);
+    }
+}
+
+void Tutorial_EQAudioProcessor::SetChainEngine(int engine)
+{
+    // Same look ahead, same states: the scalar and cascade engines compute the same samples, nothing to fade
+    if (GetEngineLookAhead(engine) == GetEngineLookAhead(chainEngine)) {
+        SelectEngine(engine);
+        return;
+    }
+
+    LeaveDualMono(); // RChain must be in sync for the old engine's pass
+    identicalSamples = 0;
+    previousEngine = chainEngine;
+    SelectEngine(engine);
+
+    // The new engine's states are whatever it left last time it ran
+    for (auto* chain : { LChain, RChain }) {
+        GetBlockChain(*chain)->resetLookAhead();
+    }
+    engineFading = true;
+}
+
+void Tutorial_EQAudioProcessor::ProcessChain(MonoChain& chain, juce::dsp::AudioBlock<float>& monoBlock)
+{
+    GetBlockChain(chain)->process(chain, monoBlock.getChannelPointer(0), (int) monoBlock.getNumSamples());
+}
+
+void Tutorial_EQAudioProcessor::ProcessChainSamples(MonoChain& chain, float* data, int numSamples)
+{
+    GetBlockChain(chain)->process(chain, data, numSamples); // Its remainder is already sample by sample
+}
+
+void Tutorial_EQAudioProcessor::ResetChain(MonoChain& chain)
+{
+    // Every look ahead, so switching engines never resumes from stale states
+    if (auto* blockChain = GetBlockChain(chain)) blockChain->reset();
+}
+
+bool Tutorial_EQAudioProcessor::IsChainIdentity() const
+{
+    for (auto fading : slotFading) {
+        if (fading) return false;
+    }
+    return LChain->isBypassed<MonoChainIdx::LowCut>() && LChain->isBypassed<MonoChainIdx::Peak>()
+        && LChain->isBypassed<MonoChainIdx::HiCut>();
+}
+
+void Tutorial_EQAudioProcessor::UpdateTail(bool isLinearPhase, int firLength)
+{
+    // The FIR's tail is its length (the extra bands are in it), the IIRs' come from their poles
+    int mainTail = isLinearPhase ? firLength : GetChainTailSamples(*LChain, SilenceFloor) + extraBands.getTailSamples(SilenceFloor);
+    if (!isLinearPhase && appliedDynamicPeak) {
+        mainTail += dynamicPeak.getTailSamples(SilenceFloor); // Whatever the MonoChain's Peak element is set to
+    }
+    tailSamples = juce::jmin(MaxDecaySamples, mainTail);
+
+    const double sr = getSampleRate();
+    tailSeconds = sr > 0.0 ? tailSamples / sr : 0.0;
+}
+
+/* static */ bool Tutorial_EQAudioProcessor::IsBlockSilent(const juce::AudioBuffer<float>& buffer, int numChannels)
+{
+    if (buffer.hasBeenCleared()) return true;
+
+    // NOTE: getMagnitude goes through FloatVectorOperations::findMinAndMax, which is vectorized
+    const int numSamples = buffer.getNumSamples();
+    for (int ch = 0; ch < juce::jmin(numChannels, buffer.getNumChannels()); ch++) {
+        if (buffer.getMagnitude(ch, 0, numSamples) > SilenceFloor) return false;
+    }
+    return true;
+}
+
+/* static */ bool Tutorial_EQAudioProcessor::AreChannelsIdentical(const float* left, const float* right, int numSamples)
+{
+    // NOTE: Bitwise, so the copied output is exactly what RChain would have made. memcmp is vectorized by every
+    // libc and stops at the first difference: true stereo costs a few samples
+    return std::memcmp(left, right, sizeof(float) * (size_t) numSamples) == 0;
+}
+
+void Tutorial_EQAudioProcessor::LeaveDualMono()
+{
+    if (!isDualMono) return;
+    isDualMono = false;
+
+    // RChain's states converged to LChain's before entering, and both got the same input since: they are LChain's
+    GetBlockChain(*RChain)->copyStatesFrom(*GetBlockChain(*LChain));
+}
@@ -9,6 +9,12 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "MultiBandEQ.h"
+#include "DynamicEQ.h"
+#include "Telemetry.h"
+#include "CpuGovernor.h"
+#include "Trace.h"
+#include "MatchedDesign.h"
 
 
 // Free types
@@ -28,9 +34,231 @@ struct ChainSettings {
     float peakFreq { 0 }, peakGaindB { 0 }, peakQ {1.f};
     float lowCutFreq {0}, hiCutFreq {0};
     int lowCutSlope {0}, hiCutSlope {0};
+    int designMode {0}; // DesignModeIdx
+
+    bool operator==(const ChainSettings& other) const
+    {
+        return peakFreq == other.peakFreq && peakGaindB == other.peakGaindB && peakQ == other.peakQ
+            && lowCutFreq == other.lowCutFreq && hiCutFreq == other.hiCutFreq
+            && lowCutSlope == other.lowCutSlope && hiCutSlope == other.hiCutSlope
+            && designMode == other.designMode;
+    }
+    bool operator!=(const ChainSettings& other) const { return !(*this == other); }
+};
+
+// Parameter registry
+
+/*! \brief Index of every plugin parameter, in the order they are registered in the layout.
+    \note Used everywhere instead of the parameter ID strings, so the audio thread never hashes a string */
+enum ParamIdx {
+    LowCutFreq,
+    HiCutFreq,
+    PeakFreq,
+    PeakGain,
+    PeakQuality,
+    LowCutSlope,
+    HiCutSlope,
+    PhaseMode,
+    FirLength,
+    PeakMode,
+    DynThreshold,
+    DynRatio,
+    DynRange,
+    DynAttack,
+    DynRelease,
+    DynDetector,
+    DesignMode,
+    StereoMode,
+    AutomationSmoothing,
+    ChainEngine,
+    Reblocking,
+    Governor,
+    NumParams
+};
+
+/*! \brief Compile-time description of one parameter. The layout, the cached handles and
+    the editor's slider attachments are all generated from ParamTable, so they can't drift apart */
+struct ParamDesc {
+    ParamIdx idx;
+    const char* id;     // Also used as the display name
+    float minVal, maxVal, interval, skew, dflt;
+    const char* const* choices; // nullptr for float params. For choices, dflt is the choice idx
+    const char* suffix; // Shown by the editor's knobs
+
+    constexpr bool isChoice() const { return choices != nullptr; }
+    constexpr int getNumChoices() const { return static_cast<int>(maxVal) + 1; }
+};
+
+namespace ParamRanges {
+    constexpr float earMinFreq = 20.f;
+    constexpr float earMaxFreq = 20000.f;
+    constexpr float skewLogFreqRange = 0.25f; // Allows having 10kHz at 90% of the knob (log scale for hi and lo freqs)
+    constexpr int numSlopes = 4; // 12, 24, 36 and 48 dB/Oct
+}
+
+inline constexpr const char* SlopeChoices[] { "12dB/Oct", "24dB/Oct", "36dB/Oct", "48dB/Oct" };
+
+/*! \brief Minimum phase runs the MonoChain then the extra bands, linear phase runs the FIR derived from the same curve.
+    The FIR folds in the extra bands' magnitudes, their biquads don't run then */
+enum PhaseModeIdx {
+    MinimumPhase,
+    LinearPhase
+};
+inline constexpr const char* PhaseModeChoices[] { "Minimum phase", "Linear phase" };
+
+/*! \brief Dynamic: the peak band's gain follows an envelope, sample by sample (minimum phase only) */
+enum PeakModeIdx {
+    StaticPeak,
+    DynamicPeak
+};
+inline constexpr const char* PeakModeChoices[] { "Static", "Dynamic" };
+
+/*! \brief What the dynamic peak band listens to */
+enum DetectorIdx {
+    DetectInput,    // The band's own input
+    DetectSidechain // Falls back to the input while the host leaves the sidechain bus disabled
+};
+inline constexpr const char* DetectorChoices[] { "Input", "Sidechain" };
+
+/*! \brief How the MonoChain's biquads are designed. Matched tracks the analog curves up to Nyquist,
+    see MatchedDesign.h */
+enum DesignModeIdx {
+    BilinearDesign,
+    MatchedDesign
+};
+inline constexpr const char* DesignModeChoices[] { "Bilinear", "Matched" };
+
+/*! \brief What the MonoChain filters: both channels, or only the mid (L+R) or side (L-R) signal, the other one
+    passing through untouched, e.g. a side only low cut (minimum phase only) */
+enum StereoModeIdx {
+    LeftRight,
+    MidOnly,
+    SideOnly
+};
+inline constexpr const char* StereoModeChoices[] { "Stereo", "Mid", "Side" };
+
+/*! \brief Per-block ramp smoothing: when the MonoChain's settings moved since the previous block, the block ramps
+    to them in sub-blocks of at least this many samples, each one redesigned. Off redesigns once per block */
+inline constexpr int AutomationSmoothingSamples[] { 0, 16, 32, 64, 128, 256 };
+inline constexpr const char* AutomationSmoothingChoices[] { "Off", "16 samples", "32 samples", "64 samples", "128 samples", "256 samples" };
+static_assert(std::size(AutomationSmoothingSamples) == std::size(AutomationSmoothingChoices), "One label per smoothing length");
+
+/*! \brief How the MonoChains' biquads are run. Same coefficients, the block ones advance K samples per step
+    (see BlockIIR.h). Switching while playing crossfades from the old engine */
+enum ChainEngineIdx {
+    ScalarChain,  // Float TDF-II sample by sample, what IIR::Filter computes. BlockIIRChain keeps the states
+    BlockIIR4,
+    BlockIIR8,
+    KernelCascade // The playing sections through the best cascade kernel of the CPU, see BiquadKernels.h
+};
+inline constexpr const char* ChainEngineChoices[] { "Scalar", "Block x4", "Block x8", "Cascade" };
+
+/*! \brief See setReblocking. Only the block engines re-block */
+enum ReblockingIdx {
+    ReblockingOff,
+    ReblockingOn
+};
+inline constexpr const char* ReblockingChoices[] { "Off", "On" };
+
+/*! \brief The CPU governor, see CpuGovernor.h. Offline renders run at full quality either way */
+enum GovernorIdx {
+    GovernorOff,
+    GovernorOn
+};
+inline constexpr const char* GovernorChoices[] { "Off", "On" };
+
+/*! \brief BlockIIRChain's look ahead for an engine, the scalar and cascade ones share the 1 sample states */
+constexpr int GetEngineLookAhead(int engine) { return engine == BlockIIR4 ? 4 : (engine == BlockIIR8 ? 8 : 1); }
+
+/*! \brief Longer kernels resolve lower freqs, at the cost of latency (half the length) and CPU */
+inline constexpr int FirLengths[] { 1024, 2048, 4096, 8192, 16384 };
+inline constexpr const char* FirLengthChoices[] { "1024", "2048", "4096", "8192", "16384" };
+static_assert(std::size(FirLengths) == std::size(FirLengthChoices), "One label per FIR length");
+static_assert(std::size(SlopeChoices) == ParamRanges::numSlopes, "One label per cut slope");
+
+inline constexpr std::array<ParamDesc, NumParams> ParamTable {{
+    { LowCutFreq,  "LowCut Freq",   ParamRanges::earMinFreq, ParamRanges::earMaxFreq, 1.f,   ParamRanges::skewLogFreqRange, ParamRanges::earMinFreq, nullptr, "Hz" },
+    { HiCutFreq,   "HighCut Freq",  ParamRanges::earMinFreq, ParamRanges::earMaxFreq, 1.f,   ParamRanges::skewLogFreqRange, ParamRanges::earMaxFreq, nullptr, "Hz" },
+    { PeakFreq,    "Peak Freq",     ParamRanges::earMinFreq, ParamRanges::earMaxFreq, 1.f,   ParamRanges::skewLogFreqRange, 750.f, nullptr, "Hz" },
+    { PeakGain,    "Peak Gain",     -24.f, 24.f,  0.5f,  1.f, 0.f, nullptr, "dB" },
+    { PeakQuality, "Peak Quality",  0.1f,  10.f,  0.05f, 1.f, 1.f, nullptr, "" },
+    { LowCutSlope, "LowCut Slope",  0.f, ParamRanges::numSlopes - 1.f, 1.f, 1.f, 0.f, SlopeChoices, "dB/Oct" },
+    { HiCutSlope,  "HighCut Slope", 0.f, ParamRanges::numSlopes - 1.f, 1.f, 1.f, 0.f, SlopeChoices, "dB/Oct" },
+    { PhaseMode,   "Phase Mode",    0.f, 1.f, 1.f, 1.f, MinimumPhase, PhaseModeChoices, "" },
+    { FirLength,   "FIR Length",    0.f, 4.f, 1.f, 1.f, 2.f, FirLengthChoices, "" }, // Defaults to 4096
+    { PeakMode,     "Peak Mode",     0.f, 1.f, 1.f, 1.f, StaticPeak, PeakModeChoices, "" },
+    { DynThreshold, "Dyn Threshold", -60.f, 0.f, 0.5f, 1.f, -20.f, nullptr, "dB" },
+    { DynRatio,     "Dyn Ratio",     1.f, 20.f, 0.1f, 0.5f, 2.f, nullptr, ":1" },
+    { DynRange,     "Dyn Range",     -24.f, 24.f, 0.5f, 1.f, -6.f, nullptr, "dB" },
+    { DynAttack,    "Dyn Attack",    0.1f, 200.f, 0.1f, 0.3f, 5.f, nullptr, "ms" },
+    { DynRelease,   "Dyn Release",   5.f, 2000.f, 1.f, 0.3f, 100.f, nullptr, "ms" },
+    { DynDetector,  "Dyn Detector",  0.f, 1.f, 1.f, 1.f, DetectInput, DetectorChoices, "" },
+    { DesignMode,   "Filter Design", 0.f, 1.f, 1.f, 1.f, BilinearDesign, DesignModeChoices, "" },
+    { StereoMode,   "Stereo Mode",   0.f, 2.f, 1.f, 1.f, LeftRight, StereoModeChoices, "" },
+    { AutomationSmoothing, "Automation Smoothing", 0.f, 5.f, 1.f, 1.f, 0.f, AutomationSmoothingChoices, "" }, // Off
+    { ChainEngine,  "Chain Engine",  0.f, 3.f, 1.f, 1.f, ScalarChain, ChainEngineChoices, "" },
+    { Reblocking,   "Re-blocking",   0.f, 1.f, 1.f, 1.f, ReblockingOff, ReblockingChoices, "" },
+    { Governor,     "CPU Governor",  0.f, 1.f, 1.f, 1.f, GovernorOn, GovernorChoices, "" },
+}};
+
+/*! \brief Checks at compile time that every row of ParamTable sits at its own enum index */
+constexpr bool isParamTableOrdered()
+{
+    for (size_t i = 0; i < ParamTable.size(); i++) {
+        if (ParamTable[i].idx != static_cast<ParamIdx>(i)) return false;
+    }
+    return true;
+}
+static_assert(isParamTableOrdered(), "ParamTable rows must follow the ParamIdx order");
+
+/*! \brief Raw value handles of every parameter, fetched once from the apvts and then read by index */
+using ParamHandles = std::array<std::atomic<float>*, NumParams>;
+
+/*! \brief Params of each of the N-band engine's bands, registered after ParamTable's as "Band 3 Freq"...
+    Off is the first type: a band only runs once the user picks another one */
+enum BandParamIdx {
+    BandTypeParam,
+    BandFreqParam,
+    BandGainParam,
+    BandQualityParam,
+    NumBandParams
+};
+inline constexpr const char* BandTypeChoices[] { "Off", "Bell", "Low Shelf", "High Shelf", "Notch" };
 
+/*! \brief Same as ParamDesc, for the params every band has */
+struct BandParamDesc {
+    BandParamIdx idx;
+    const char* name; // The id is "Band <n> " followed by it
+    float minVal, maxVal, interval, skew, dflt;
+    const char* const* choices;
+
+    constexpr bool isChoice() const { return choices != nullptr; }
+    constexpr int getNumChoices() const { return static_cast<int>(maxVal) + 1; }
 };
 
+inline constexpr std::array<BandParamDesc, NumBandParams> BandParamTable {{
+    { BandTypeParam,    "Type",    0.f, (float) std::size(BandTypeChoices) - 1.f, 1.f, 1.f, 0.f, BandTypeChoices },
+    { BandFreqParam,    "Freq",    ParamRanges::earMinFreq, ParamRanges::earMaxFreq, 1.f, ParamRanges::skewLogFreqRange, 1000.f, nullptr },
+    { BandGainParam,    "Gain",    -24.f, 24.f, 0.5f, 1.f, 0.f, nullptr },
+    { BandQualityParam, "Quality", 0.1f, 10.f, 0.05f, 1.f, 1.f, nullptr },
+}};
+
+static_assert(std::size(BandTypeChoices) == static_cast<size_t>(BandType::Notch) + 2, "Off, then one label per BandType");
+
+using BandParamHandles = std::array<std::array<std::atomic<float>*, NumBandParams>, MultiBandEQ::MaxBands>;
+
+/*! \brief Binary plugin state: a fixed 8 bytes header, then one little endian float (raw value) per param,
+    in ParamIdx order. Params are only ever appended to ParamTable, so any version can be read by index.
+    From version 2, the bands follow: their number of values (16 bits), then the values band after band,
+    in BandParamIdx order. From version 3, the current program (32 bits) ends it */
+namespace StateFormat {
+    constexpr juce::uint32 Magic = 0x53514554; // "TEQS", tells it apart from the old ValueTree states
+    constexpr int Version = 3;
+    constexpr int HeaderSize = 8; // Magic (32 bits), version (16 bits), number of params (16 bits)
+    constexpr int FirstVersionWithBands = 2;
+    constexpr int FirstVersionWithProgram = 3;
+}
+
 /*! \brief Represent the whole monopath of our 3-band parametric EQ
     \note is global so it can be instantiated by pluginEditor */
 using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
@@ -105,33 +333,128 @@ static inline int GetCutFilterTransferOrder(int slopeChoiceIdx) {
 }
 
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+/*! \brief Reads the current param values by index, no string lookup. Safe to call from the audio thread */
+ChainSettings getChainSettings(const ParamHandles& params);
+/*! \brief The other way around: a state (StateFormat) setStateInformation loads, every other param at its default */
+juce::MemoryBlock MakeStateFromSettings(const ChainSettings& cs);
+
+inline bool IsLinearPhase(const ParamHandles& params)
+{
+    return static_cast<int>(params[PhaseMode]->load()) == LinearPhase;
+}
+
+inline bool IsDynamicPeak(const ParamHandles& params)
+{
+    return static_cast<int>(params[PeakMode]->load()) == DynamicPeak;
+}
+
+inline bool IsReblocking(const ParamHandles& params)
+{
+    return static_cast<int>(params[Reblocking]->load()) == ReblockingOn;
+}
+
+inline bool IsGovernorOn(const ParamHandles& params)
+{
+    return static_cast<int>(params[Governor]->load()) == GovernorOn;
+}
+
+inline int GetStereoMode(const ParamHandles& params)
+{
+    return juce::jlimit((int) LeftRight, (int) SideOnly, static_cast<int>(params[StereoMode]->load()));
+}
+
+/*! \brief One of the N-band engine's bands, from its params */
+BandSettings getBandSettings(const BandParamHandles& params, int bandIdx);
+
+/*! \brief The peak band's params plus the envelope's, for DynamicPeakBand */
+DynamicBandSettings getDynamicBandSettings(const ParamHandles& params);
+
+/*! \brief Kernel length in samples picked by the FIR Length param */
+inline int GetFirLength(const ParamHandles& params)
+{
+    const int idx = juce::jlimit(0, static_cast<int>(std::size(FirLengths)) - 1, static_cast<int>(params[FirLength]->load()));
+    return FirLengths[idx];
+}
+
+/*! \brief Minimum sub-block length picked by the Automation Smoothing param, 0 when off */
+inline int GetAutomationSmoothing(const ParamHandles& params)
+{
+    const int idx = juce::jlimit(0, static_cast<int>(std::size(AutomationSmoothingSamples)) - 1,
+                                 static_cast<int>(params[AutomationSmoothing]->load()));
+    return AutomationSmoothingSamples[idx];
+}
+
+inline int GetChainEngine(const ParamHandles& params)
+{
+    return juce::jlimit((int) ScalarChain, (int) KernelCascade, static_cast<int>(params[ChainEngine]->load()));
+}
+
+/*! \brief Sub-blocks a block is cut into when automation smoothing is on: as many as fit, none shorter than
+    minSubBlockSamples. Sub-block i ends at numSamples * (i + 1) / numSubBlocks */
+inline int GetNumAutomationSubBlocks(int numSamples, int minSubBlockSamples)
+{
+    return minSubBlockSamples > 0 ? juce::jmax(1, numSamples / minSubBlockSamples) : 1;
+}
 
 Coefs MakePeakFilter(const ChainSettings cs, double sampleRate);
 
 // NOTE: could have been better to pass the 2 floats (slope and freq) instead of cs struct
 inline auto MakeLowCutFilter(const ChainSettings cs, double sampleRate)
 {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(
-        cs.lowCutFreq, sampleRate, GetCutFilterTransferOrder(cs.lowCutSlope));
+    const int order = GetCutFilterTransferOrder(cs.lowCutSlope);
+    if (cs.designMode == MatchedDesign) return DesignMatchedButterworth(cs.lowCutFreq, sampleRate, order, true);
+    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(cs.lowCutFreq, sampleRate, order);
 }
 
 
 inline auto MakeHighCutFilter(const ChainSettings cs, double sampleRate)
 {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(
-        cs.hiCutFreq, sampleRate, GetCutFilterTransferOrder(cs.hiCutSlope));
+    const int order = GetCutFilterTransferOrder(cs.hiCutSlope);
+    if (cs.designMode == MatchedDesign) return DesignMatchedButterworth(cs.hiCutFreq, sampleRate, order, false);
+    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(cs.hiCutFreq, sampleRate, order);
 }
 
 inline void UpdateCoefficients(Coefs &old, const Coefs &replacements) {
     *old = *replacements;
 }
 
+using CutCoefs = juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>;
+
+/*! \brief Every coefficient a MonoChain needs, designed ahead of time (e.g. for each program) */
+struct ChainCoefs {
+    Coefs peak;
+    CutCoefs lowCut, hiCut;
+};
+
+ChainCoefs MakeChainCoefs(const ChainSettings& cs, double sampleRate);
+
+/*! \brief Points the chain's filters to the coefficients. Only pointer swaps, no allocation,
+    so the coefficient objects are shared and must never be modified in place afterwards */
+void ApplyChainCoefs(MonoChain& chain, const ChainCoefs& coefs, const ChainSettings& cs);
+
+/*! \brief Designs every band of a MonoChain from the settings. Used by the UI and the linear phase kernel,
+    which "simulate" the EQ outside of the audio thread */
+void ConfigureMonoChain(MonoChain& chain, const ChainSettings& cs, double sampleRate);
+
+/*! \brief Linear magnitude of the active stages of a cut filter at freq */
+double GetCutFilterMagnitudeForFrequency(const CutFilter& cut, double freq, double sampleRate);
+
+/*! \brief Linear magnitude of the whole chain at freq, skipping bypassed filters */
+double GetChainMagnitudeForFrequency(const MonoChain& chain, double freq, double sampleRate);
+
+/*! \brief Samples for the whole chain to decay by floorGain, from the pole radii of its active sections */
+int GetChainTailSamples(const MonoChain& chain, double floorGain);
+
+
+class LinearPhaseEQ;
+class SharedResources;
+class BlockIIRChain;
 
 //==============================================================================
 /**
 */
-class Tutorial_EQAudioProcessor  : public juce::AudioProcessor
+class Tutorial_EQAudioProcessor  : public juce::AudioProcessor,
+                                   private juce::AsyncUpdater // Latency changes are reported from the message thread
 {
 public:
     //==============================================================================
@@ -179,30 +502,305 @@ public:
 
     juce::AudioProcessorValueTreeState apvts { *this, nullptr, "Parameters",
          createParamLayout() };
+
+    const ParamHandles& getParamHandles() const { return paramHandles; }
+
+    /*! \brief Bands deviating less than that from flat over 20Hz-20kHz are dropped from processing */
+    void setNeutralThresholdDb(float thresholdDb);
+    static constexpr float DefaultNeutralThresholdDb = 0.01f;
+
+    /*! \brief Sets the params of one of the N-band engine's bands, like the host would. The audio thread picks
+        them up at the start of the next block */
+    void setExtraBand(int bandIdx, const BandSettings& band);
+    static juce::String GetBandParamId(int bandIdx, BandParamIdx idx);
+
+    /*! \brief Sets the Chain Engine param, like the host would. The audio thread switches at the start of a block
+        where nothing else is in transition */
+    void setChainEngine(ChainEngineIdx engine) { SetParamValue(ChainEngine, (float) engine); }
+    ChainEngineIdx getChainEngine() const { return static_cast<ChainEngineIdx>(GetChainEngine(paramHandles)); }
+
+    /*! \brief Quality the governor currently allows, see CpuGovernor.h. Full unless the process overruns */
+    QualityTier getQualityTier() const { return governor.getTier(); }
+    int getNumTierChanges() const { return governor.getNumTierChanges(); }
+    /*! \brief Sets the CPU Governor param, like the host would */
+    void setGovernorEnabled(bool isEnabled) { SetParamValue(Governor, (float) (isEnabled ? GovernorOn : GovernorOff)); }
+
+    /*! \brief Sets the Automation Smoothing param, like the host would: minSubBlockSamples must be one of
+        AutomationSmoothingSamples (0 is off). See ProcessAutomationRamp for what it does, and doesn't */
+    void setAutomationSmoothing(int minSubBlockSamples);
+    int getAutomationSmoothing() const { return GetAutomationSmoothing(paramHandles); }
+
+    /*! \brief Re-blocking, for hosts calling with erratic and tiny sizes (e.g. 1-7 samples around loop points).
+        Calls shorter than the control period skip the control work (param reads, redesign checks, silence and dual
+        mono detection) while nothing is in transition, and run the chains straight on the samples. Longer calls run
+        the engine on multiples of its step, aligned, and the remainder sample by sample. Adds no latency.
+        Only the block engines re-block, the others have no step. Sets the Re-blocking param */
+    void setReblocking(bool isEnabled) { SetParamValue(Reblocking, (float) (isEnabled ? ReblockingOn : ReblockingOff)); }
+    /*! \brief Whether the current engine re-blocks, the param on or not */
+    bool isReblocking() const { return reblockStep > 0; }
+    static constexpr int MaxControlPeriod = 64; // Param changes wait at most that long, like with 64 sample blocks
+
+    /*! \brief Blocks until the job prepareToPlay queued is done, e.g. for a benchmark to time the whole preparation */
+    void waitForBackgroundPreparation();
   
 private:
 
-    MonoChain LChain, RChain;
+    /*! \note Filled in the constructor, after apvts has created the params */
+    ParamHandles paramHandles {};
+    std::array<juce::RangedAudioParameter*, NumParams> paramObjects {}; // To restore states by index
+
+    /*! \brief Sets a param from its raw value, notifying the host */
+    void SetParamValue(ParamIdx idx, float value);
+
+    /*! \brief Returns false if data isn't a binary state, e.g. one saved as a ValueTree by older versions */
+    bool ReadBinaryState(const void* data, int sizeInBytes);
+
+    /*! \brief Two L/R pairs of MonoChain. LChain/RChain point to the playing pair, the other one is
+        where the next program is loaded and faded in from, then the pointers flip */
+    std::array<MonoChain, 2> leftChains, rightChains;
+    MonoChain* LChain { &leftChains[0] };
+    MonoChain* RChain { &rightChains[0] };
+
+    /*! \brief States of each MonoChain, whatever the engine, same index as leftChains/rightChains.
+        Created by the first prepareToPlay, so switching engines while playing doesn't allocate */
+    std::array<std::unique_ptr<BlockIIRChain>, 2> leftBlockChains, rightBlockChains;
+    int chainEngine { ScalarChain };    // ChainEngineIdx running the chains, read by the audio thread
+    int previousEngine { ScalarChain }; // The one faded out, while engineFading
+    bool engineFading { false };        // The old engine runs on a copy for one block, crossfaded to the new one
+    CascadeKernel cascadeKernel { ProcessCascadeScalar }; // The CPU's best, picked in prepareToPlay
+
+    /*! \brief nullptr until prepared */
+    BlockIIRChain* GetBlockChain(const MonoChain& chain);
+    /*! \brief Runs the chains with engine from now on, its states as they are. Follows re-blocking to its step */
+    void SelectEngine(int engine);
+    /*! \brief A live switch: the new engine starts from cleared states, the old one runs once more next to it */
+    void SetChainEngine(int engine);
+    /*! \brief The whole chain (bypassed elements skipped) with the prepared engine */
+    void ProcessChain(MonoChain& chain, juce::dsp::AudioBlock<float>& monoBlock);
+    /*! \brief Clears the chain's states, wherever the prepared engine keeps them */
+    void ResetChain(MonoChain& chain);
+    /*! \brief ProcessChain without any AudioBlock or context, for a few samples. Same states, whatever the engine */
+    void ProcessChainSamples(MonoChain& chain, float* data, int numSamples);
+
+    /*! \brief -120 dB, input under it is silence and tails are considered gone under it */
+    static constexpr float SilenceFloor = 1e-6f;
+
+    /*! \brief Replaces LChain and RChain when the Phase Mode param is Linear phase. Created the first time it is:
+        by prepareToPlay, or while playing by prepareJob. Then kept, and prepared with the rest */
+    std::unique_ptr<LinearPhaseEQ> linearPhase;
+    std::atomic<bool> isLinearPhaseReady { false }; // Set once linearPhase is created and prepared
+    juce::dsp::ProcessSpec linearPhaseSpec { 0.0, 0, 0 }; // What prepareJob prepares it for
+    std::atomic<int> targetLatency { 0 };
+    void handleAsyncUpdate() override;
+
+    /*! \brief Coefficients the MonoChains stop pointing to are handed to the message thread, which frees them
+        (handleAsyncUpdate). Only the ones nothing else holds are retired, e.g. never a program's.
+        Sized in prepareToPlay for the shortest smoothing sub-blocks, each one retiring a whole chain, over a few
+        blocks. Automation smoothing cuts fewer sub-blocks when the message thread lags more than that */
+    static constexpr int CoefsPerChain = 9;     // Peak, 4 low cut and 4 high cut sections
+    static constexpr int RetiredCoefsBlocks = 8; // Blocks the message thread may lag behind
+    static constexpr int MinRetiredCoefsCapacity = 1024;
+    std::vector<Coefs> retiredCoefs = std::vector<Coefs>((size_t) MinRetiredCoefsCapacity);
+    juce::AbstractFifo retiredCoefsFifo { MinRetiredCoefsCapacity };
+    juce::CriticalSection retiredCoefsLock; // The message thread's drain against prepareToPlay's resize
+
+    /*! \brief ApplyChainCoefs for the audio thread: the chain's old coefficients are retired, not freed there */
+    void SwapChainCoefs(MonoChain& chain, const ChainCoefs& coefs, const ChainSettings& cs);
+    void RetireCoefs(const Coefs& coefs);
+    void FreeRetiredCoefs();
+    void ResizeRetiredCoefs(int samplesPerBlock);
+    /*! \brief Smoothing sub-blocks the retired coefficients FIFO has room for, one design kept for the rest */
+    int GetMaxAutomationSubBlocks() const { return juce::jmax(1, retiredCoefsFifo.getFreeSpace() / CoefsPerChain - 1); }
+
+    /*! \brief Extra bands run after the MonoChains. With no active band it costs nothing */
+    MultiBandEQ extraBands;
+    BandParamHandles bandParamHandles {};
+    std::array<std::array<juce::RangedAudioParameter*, NumBandParams>, MultiBandEQ::MaxBands> bandParamObjects {};
+
+    /*! \brief Redesigns the bands whose params moved. Returns true if at least one band changed */
+    bool ApplyBandParams();
+    /*! \brief Straight from the params, for the threads that can't read extraBands */
+    ExtraBandSettings GetExtraBandSettings() const;
+
+    /*! \brief Replaces the MonoChain's Peak element when the Peak Mode param is Dynamic */
+    DynamicPeakBand dynamicPeak;
+    bool appliedDynamicPeak { false };
+    bool peakModeFading { false }; // Set for the block in which the mode changes, crossfaded from the old one
+    juce::AudioBuffer<float> peakModeScratch; // Old mode's output during that block, sized in prepareToPlay
+
+    /*! \brief Runs the peak band of whichever mode is on. detector may have no channel (band's own input) */
+    void ProcessPeak(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                     const juce::dsp::AudioBlock<float>& detector);
+    void ProcessDynamicPeak(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                            const juce::dsp::AudioBlock<float>& detector);
+    /*! \brief Clears the states of the mode that takes over, then fades to it */
+    void SetPeakMode(bool isDynamic);
+
+    /*! \brief Per stage timing of processBlock. Empty unless TUTORIAL_EQ_ENABLE_TELEMETRY is set */
+    InstanceTelemetry telemetry;
+
+    /*! \brief Steps the quality down when processBlock nears its deadline, and back up */
+    CpuGovernor governor;
+    QualityTier appliedTier { QualityTier::Full };
+    int samplesSinceDesign { 0 }; // CoarseUpdates tier: param changes wait for it to reach the update period
+    void ApplyQualityTier(QualityTier tier);
+
+
+    // Silence detection
+    // =====================================
 
+    /*! \brief What the filters were last designed for. Coefficients and tail are only recomputed when it changes */
+    ChainSettings appliedSettings;
+    bool appliedLinearPhase { false };
+    int appliedFirLength { 0 };
+    std::atomic<bool> filtersDirty { true }; // Set from the message thread (prepare, state restore)
 
-    
-    // Peak filter
+    /*! \brief Samples for the current cascade to decay under SilenceFloor, from its pole radii */
+    int tailSamples { 0 };
+    std::atomic<double> tailSeconds { 0.0 };
+    int silentSamples { 0 };  // Since the input went silent
+    bool isSleeping { false }; // Tail has fully decayed, blocks are zeros without processing
+
+    // Neutral bands
+    // =====================================
+
+    std::atomic<float> neutralThresholdDb { DefaultNeutralThresholdDb };
+
+    /*! \brief One per MonoChain element. Set for the block in which it enters or leaves the path */
+    std::array<bool, 3> slotFading {};
+    std::vector<float> fadeScratch; // Dry copy of a channel during a fade, sized in prepareToPlay
+
+    /*! \brief Bypasses (at the MonoChain level) the elements deviating less than the threshold */
+    void UpdateNeutralBands(const ChainSettings& cs);
+    template <int Idx> void SetSlotActive(bool isActive);
+    template <int Idx> void ProcessSlot(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock);
+    bool IsChainIdentity() const;
+
+    /*! \brief Redesigns the MonoChains (minimum phase only) and recomputes the tail */
+    void DesignFilters(const ChainSettings& cs, bool isLinearPhase, int firLength);
+    /*! \brief LowCut, peak (static or dynamic) and HiCut, in MonoChain order */
+    void ProcessMonoChains(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                           const juce::dsp::AudioBlock<float>& detector);
+    void UpdateTail(bool isLinearPhase, int firLength);
+    static bool IsBlockSilent(const juce::AudioBuffer<float>& buffer, int numChannels);
+
+
+    // Automation smoothing
     // =====================================
 
-    // NOTE: Helper function to prevent redundantly updating peak filters in processblock and in preparetoplay
-    void UpdatePeakFilter(const ChainSettings& cs);
+    /*! \brief Where the host's ramp from from to to is at fraction (0-1) of it. Continuous params move linearly in
+        their normalised range, like host automation. Choices (slopes, design) can't ramp, they are already to's */
+    ChainSettings InterpolateSettings(const ChainSettings& from, const ChainSettings& to, float fraction) const;
+    /*! \brief ProcessMonoChains sub-block after sub-block, each one designed for the end of its share of the ramp
+        from rampStart. The first one is already designed by processBlock */
+    void ProcessAutomationRamp(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                                const juce::dsp::AudioBlock<float>& detector, const ChainSettings& rampStart, int numSubBlocks);
+
+
+    // Re-blocking
+    // =====================================
+
+    static constexpr size_t ReblockAlignment = 32;
+
+    bool appliedReblocking { false }; // The param, read by processBlock
+    int preparedBlockSize { 0 };
+    int reblockStep { 0 };     // Block engine step (4 or 8 samples) when on, 0 when off. See UpdateReblockStep
+    int controlPeriod { 0 };   // Short calls skip the control work until that many samples went by
+    int samplesSinceControl { 0 };
+    juce::HeapBlock<char> reblockStorage;
+    juce::dsp::AudioBlock<float> reblockScratch; // Aligned copy of host channels that aren't, sized in prepareToPlay
+
+    /*! \brief From appliedReblocking and chainEngine */
+    void UpdateReblockStep();
+
+    /*! \brief Nothing in transition, and nothing the sample by sample path can't run (FIR, dynamic peak, fades,
+        extra bands, a pending redesign or program) */
+    bool CanSkipControl(const juce::AudioBuffer<float>& buffer) const;
+    /*! \brief A call shorter than the control period: the chains only, sample by sample */
+    void ProcessShortCall(juce::AudioBuffer<float>& buffer);
+    /*! \brief ProcessMonoChains on the longest multiple of the step (on an aligned copy if needed), then the remainder */
+    void ProcessReblocked(juce::dsp::AudioBlock<float>& leftBlock, juce::dsp::AudioBlock<float>& rightBlock,
+                          const juce::dsp::AudioBlock<float>& detector);
+
 
+    // Dual mono
+    // =====================================
+
+    /*! \brief Set while L and R are identical: only LChain runs, its output is copied to the right channel.
+        Entered once the inputs have been identical for the whole tail, so RChain's states have converged to
+        LChain's. RChain then sits idle and takes LChain's states when the channels differ again */
+    bool isDualMono { false };
+    int identicalSamples { 0 }; // Since L and R last differed
+    /*! \brief Brings RChain's states back to LChain's, before anything runs the two chains apart again */
+    void LeaveDualMono();
+    static bool AreChannelsIdentical(const float* left, const float* right, int numSamples);
+
+
+    // Mid/side
+    // =====================================
+
+    int appliedStereoMode { LeftRight };
+    int previousStereoMode { LeftRight };
+    bool stereoModeFading { false }; // The old mode runs on a copy for one block, crossfaded to the new one
+    juce::AudioBuffer<float> stereoModeScratch; // Sized in prepareToPlay
+    std::vector<float> midSideScratch;          // The path the MonoChain doesn't filter, while in transition
+
+    void SetStereoMode(int mode);
+    /*! \brief Everything the IIR path runs after the coefficient updates, in the given stereo mode */
+    void ProcessStereoMode(int mode, juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& detector,
+                           const ChainSettings& rampStart, int numSubBlocks);
+    /*! \brief In steady state, one fused pass (ProcessMidSideFused). Transitions (fades, programs, automation
+        smoothing, the dynamic peak) run the stereo code on the filtered path, encoded to both channels */
+    void ProcessMidSide(bool isSide, juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& detector,
+                        const ChainSettings& rampStart, int numSubBlocks);
+    /*! \brief Encodes L/R on load, runs the path through LChain's active sections, decodes on store */
+    template <bool IsSide>
+    void ProcessMidSideFused(float* left, float* right, int numSamples);
+
+
+    // Programs
+    // =====================================
+
+    /*! \brief Coefficients of every factory program at the current sample rate, fetched by the prepare job.
+        Designed once per process and rate, every instance points to the same ones */
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+    std::shared_ptr<const std::vector<ChainCoefs>> programCoefsOwner; // Only touched by the prepare job and prepareToPlay
+    std::atomic<const std::vector<ChainCoefs>*> programCoefs { nullptr }; // Published once owned, nullptr until then
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<int> pendingProgram { -1 }; // Set by setCurrentProgram, taken by the audio thread
+    /*! \brief Odd while setCurrentProgram sets the params. The audio thread only follows the params, and takes
+        the pending program, in blocks where it stayed even: the params then already are the program's */
+    std::atomic<juce::uint32> programParamsVersion { 0 };
+    bool isProgramFading { false };
+    juce::AudioBuffer<float> programScratch; // The faded in program is processed there, sized in prepareToPlay
+
+    /*! \brief Loads the program in the spare pair of chains, processBlock then crossfades to it */
+    void StartProgramChange(int index, const ChainSettings& paramSettings, bool isLinearPhase);
+    void ProcessProgramFade(juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& detector);
+    MonoChain& GetSpareChain(std::array<MonoChain, 2>& chains, const MonoChain* active)
+    {
+        return active == &chains[0] ? chains[1] : chains[0];
+    }
+
+
+    // Background preparation
+    // =====================================
 
-    // Cut filters
-    // =====================================    
+    /*! \brief prepareToPlay only does what the first block needs, this job (on the shared PrepareThreadPool)
+        builds the rest. Until it is done, what depends on it waits (e.g. program changes stay pending) */
+    class PrepareJob;
+    juce::SharedResourcePointer<PrepareThreadPool> preparePool;
+    std::unique_ptr<PrepareJob> prepareJob;
+    double preparedSampleRate { 0.0 }; // What the job prepares for, set before it is queued
 
-    void UpdateCutFilters(const ChainSettings& chainSettings);
+    void PrepareInBackground();
+    /*! \brief Waits for a queued or running job, e.g. before its results go stale */
+    void CancelBackgroundPreparation();
 
 
+    /*! \brief Asks the audio thread to redesign the filters (and tail) on its next block */
     inline void UpdateFilters() {        
-        auto chainSettings = getChainSettings(apvts); // Will return values of the knobs/ctrls
-        UpdatePeakFilter(chainSettings);
-        UpdateCutFilters(chainSettings);
+        filtersDirty = true;
     }
 
     //==============================================================================
@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+    Multi-instance scaling benchmark, see ScalingBenchmark.h
+
+  ==============================================================================
+*/
+
+#include "ScalingBenchmark.h"
+#include "PluginProcessor.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+ #include <fstream>
+#endif
+
+namespace {
+    constexpr int InstanceCounts[] { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+    constexpr int WarmupBlocks = 16; // Program fade, first allocations, cold caches
+    constexpr int MeasuredBlocks = 200;
+    constexpr int BenchProgram = 1;  // Non neutral, so no instance skips processing
+
+    /*! \brief -1 if unknown */
+    double GetResidentBytes()
+    {
+       #if JUCE_LINUX
+        std::ifstream statm("/proc/self/statm");
+        long totalPages = 0, residentPages = 0;
+        if (statm >> totalPages >> residentPages) {
+            return (double) residentPages * (double) sysconf(_SC_PAGESIZE);
+        }
+       #endif
+        return -1.0;
+    }
+
+    /*! \brief Hardware cache misses of the calling thread (the graph renders on it). Linux only,
+        and needs perf_event_paranoid to allow it */
+    class CacheMissCounter
+    {
+    public:
+        CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            perf_event_attr attr {};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+           #endif
+        }
+
+        ~CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            if (fd >= 0) close(fd);
+           #endif
+        }
+
+        bool isAvailable() const { return fd >= 0; }
+
+        void start()
+        {
+           #if JUCE_LINUX
+            if (fd < 0) return;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+           #endif
+        }
+
+        /*! \brief Misses since start(), -1 if unavailable */
+        double stop()
+        {
+           #if JUCE_LINUX
+            if (fd < 0) return -1.0;
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            juce::uint64 count = 0;
+            return read(fd, &count, sizeof(count)) == (ssize_t) sizeof(count) ? (double) count : -1.0;
+           #else
+            return -1.0;
+           #endif
+        }
+
+    private:
+        int fd { -1 };
+
+        JUCE_DECLARE_NON_COPYABLE (CacheMissCounter)
+    };
+
+    const char* GetTopologyName(GraphTopology topology)
+    {
+        return topology == GraphTopology::Series ? "series" : "parallel";
+    }
+}
+
+
+// Free functions
+
+ScalingResult RunScalingBenchmark(GraphTopology topology, int numInstances, double sampleRate, int blockSize)
+{
+    using Graph = juce::AudioProcessorGraph;
+    using IO = Graph::AudioGraphIOProcessor;
+    constexpr int numChannels = 2;
+
+    ScalingResult result { topology, numInstances, 0.0, 0.0, 0.0, -1.0, -1.0 };
+    const double bytesBefore = GetResidentBytes();
+
+    // NOTE: UpdateKind::none, or every addition would rebuild the whole graph (quadratic for 1000 nodes)
+    Graph graph;
+    const auto input = graph.addNode(std::make_unique<IO>(IO::audioInputNode), {}, Graph::UpdateKind::none);
+    const auto output = graph.addNode(std::make_unique<IO>(IO::audioOutputNode), {}, Graph::UpdateKind::none);
+
+    auto connect = [&graph](Graph::NodeID from, Graph::NodeID to) {
+        for (int ch = 0; ch < numChannels; ch++) {
+            graph.addConnection({ { from, ch }, { to, ch } }, Graph::UpdateKind::none);
+        }
+    };
+
+    auto previous = input->nodeID;
+    for (int i = 0; i < numInstances; i++) {
+        auto eq = std::make_unique<Tutorial_EQAudioProcessor>();
+        eq->setCurrentProgram(BenchProgram);
+        const auto node = graph.addNode(std::move(eq), {}, Graph::UpdateKind::none);
+
+        if (topology == GraphTopology::Series) {
+            connect(previous, node->nodeID);
+            previous = node->nodeID;
+        } else {
+            connect(input->nodeID, node->nodeID);
+            connect(node->nodeID, output->nodeID); // The graph sums what reaches the output
+        }
+    }
+    if (topology == GraphTopology::Series) {
+        connect(previous, output->nodeID);
+    }
+
+    graph.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    graph.prepareToPlay(sampleRate, blockSize);
+
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random rng(0x5eed);
+    auto fillNoise = [&] {
+        for (int ch = 0; ch < numChannels; ch++) {
+            auto* data = buffer.getWritePointer(ch);
+            for (int i = 0; i < blockSize; i++) data[i] = 0.25f * (rng.nextFloat() * 2.f - 1.f);
+        }
+    };
+
+    for (int i = 0; i < WarmupBlocks; i++) {
+        fillNoise();
+        graph.processBlock(buffer, midi);
+    }
+
+    const double bytesAfter = GetResidentBytes();
+    if (bytesBefore >= 0.0 && bytesAfter >= 0.0) {
+        result.bytesPerInstance = (bytesAfter - bytesBefore) / numInstances;
+    }
+
+    CacheMissCounter cacheMisses;
+    double totalSeconds = 0.0, totalMisses = 0.0;
+    for (int i = 0; i < MeasuredBlocks; i++) {
+        fillNoise(); // Outside of the measure
+
+        cacheMisses.start();
+        const auto start = juce::Time::getHighResolutionTicks();
+        graph.processBlock(buffer, midi);
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        totalMisses += cacheMisses.stop();
+
+        totalSeconds += seconds;
+        result.worstCallbackMs = juce::jmax(result.worstCallbackMs, seconds * 1000.0);
+    }
+    graph.releaseResources();
+
+    result.meanCallbackMs = totalSeconds * 1000.0 / MeasuredBlocks;
+    result.deadlineLoad = (totalSeconds / MeasuredBlocks) / (blockSize / sampleRate);
+    if (cacheMisses.isAvailable()) {
+        result.cacheMissesPerCallback = totalMisses / MeasuredBlocks;
+    }
+    return result;
+}
+
+void RunAllScalingBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+
+    for (auto topology : { GraphTopology::Series, GraphTopology::Parallel }) {
+        for (int numInstances : InstanceCounts) {
+            const auto r = RunScalingBenchmark(topology, numInstances, sampleRate, blockSize);
+            juce::Logger::writeToLog(juce::String(GetTopologyName(topology)) + " x" + juce::String(numInstances)
+                                     + ": mean " + juce::String(r.meanCallbackMs, 3) + " ms"
+                                     + ", worst " + juce::String(r.worstCallbackMs, 3) + " ms"
+                                     + ", load " + juce::String(r.deadlineLoad * 100.0, 1) + "%"
+                                     + ", " + (r.bytesPerInstance >= 0.0 ? juce::String(r.bytesPerInstance / 1024.0, 1) + " KiB/instance" : "memory n/a")
+                                     + ", " + (r.cacheMissesPerCallback >= 0.0 ? juce::String(r.cacheMissesPerCallback, 0) + " cache misses/callback" : "cache misses n/a"));
+        }
+    }
+}
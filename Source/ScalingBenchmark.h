@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    Multi-instance scaling benchmark.
+
+    Builds a headless juce::AudioProcessorGraph holding N instances of the
+    plugin, either in series (each one feeds the next) or in parallel (all
+    fed by the input, summed at the output), then times the graph's
+    callback. The same thing vst3_test.filtergraph does by hand in the
+    AudioPluginHost, for N from 1 to 1000.
+
+    Reported per N: mean and worst callback time (also as a share of the
+    block's deadline), resident memory per instance and, on Linux, the
+    hardware cache misses per callback.
+
+    Runs in the Tutorial_EQ_Benchmarks console app (Benchmarks/), never in
+    the plugin: "Tutorial_EQ_Benchmarks scaling" runs it alone.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+enum class GraphTopology {
+    Series,
+    Parallel
+};
+
+struct ScalingResult {
+    GraphTopology topology;
+    int numInstances;
+    double meanCallbackMs, worstCallbackMs;
+    double deadlineLoad;       // Mean callback time / block duration. Over 1 the host drops out
+    double bytesPerInstance;   // Resident memory growth, -1 where it can't be read
+    double cacheMissesPerCallback; // -1 where the counter isn't available
+};
+
+/*! \brief Times one graph of numInstances plugins */
+ScalingResult RunScalingBenchmark(GraphTopology topology, int numInstances, double sampleRate, int blockSize);
+
+/*! \brief Sweeps N from 1 to 1000 for both topologies, one log line per graph */
+void RunAllScalingBenchmarks();
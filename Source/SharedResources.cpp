@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    Immutable data shared by every instance, see SharedResources.h
+
+  ==============================================================================
+*/
+
+#include "SharedResources.h"
+
+
+SharedResources::SharedResources()
+{
+    for (const auto& desc : ParamTable) {
+        paramIds[desc.idx] = desc.id;
+        if (desc.isChoice()) {
+            choiceLabels[desc.idx] = juce::StringArray(desc.choices, desc.getNumChoices());
+        }
+    }
+
+    for (int band = 0; band < MultiBandEQ::MaxBands; band++) {
+        for (const auto& desc : BandParamTable) {
+            bandParamIds[(size_t) band][desc.idx] = Tutorial_EQAudioProcessor::GetBandParamId(band, desc.idx);
+        }
+    }
+    bandTypeLabels = juce::StringArray(BandTypeChoices, (int) std::size(BandTypeChoices));
+}
+
+std::shared_ptr<const SharedResources::ProgramCoefs> SharedResources::getProgramCoefs(
+    double sampleRate, const std::function<ProgramCoefs(double)>& design)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto& coefs = programCoefs[sampleRate];
+    if (coefs == nullptr) {
+        coefs = std::make_shared<const ProgramCoefs>(design(sampleRate));
+    }
+    return coefs;
+}
+
+std::shared_ptr<const std::vector<double>> SharedResources::getLogFreqGrid(int numPoints)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto& grid = logFreqGrids[numPoints];
+    if (grid == nullptr) {
+        std::vector<double> freqs((size_t) juce::jmax(0, numPoints));
+        for (size_t i = 0; i < freqs.size(); i++) {
+            freqs[i] = juce::mapToLog10(double(i) / double(numPoints), 20.0, 20000.0);
+        }
+        grid = std::make_shared<const std::vector<double>>(std::move(freqs));
+    }
+    return grid;
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    Immutable data shared by every instance of the plugin in the process.
+
+    Held through juce::SharedResourcePointer: built by the first instance,
+    freed with the last one. Everything in it is read-only once built, so
+    the 100th instance only takes references to what the first one made
+    (param names and labels, factory program coefficients per sample rate,
+    log frequency grids of the response curve...).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+
+class SharedResources
+{
+public:
+    SharedResources();
+
+    /*! \brief juce::String is reference counted: copies share this storage */
+    const juce::String& getParamId(ParamIdx idx) const { return paramIds[idx]; }
+    /*! \brief Empty for float params */
+    const juce::StringArray& getChoiceLabels(ParamIdx idx) const { return choiceLabels[idx]; }
+    const juce::String& getBandParamId(int bandIdx, BandParamIdx idx) const { return bandParamIds[(size_t) bandIdx][idx]; }
+    const juce::StringArray& getBandTypeLabels() const { return bandTypeLabels; }
+
+    using ProgramCoefs = std::vector<ChainCoefs>;
+    /*! \brief Coefficients of the factory programs at that rate. The first instance to ask designs them with design().
+        \note The coefficient objects are shared between instances, they must never be modified in place */
+    std::shared_ptr<const ProgramCoefs> getProgramCoefs(double sampleRate, const std::function<ProgramCoefs(double)>& design);
+
+    /*! \brief Freq (20Hz-20kHz, log scale) of each of the numPoints points of the response curve */
+    std::shared_ptr<const std::vector<double>> getLogFreqGrid(int numPoints);
+
+private:
+    std::array<juce::String, NumParams> paramIds;
+    std::array<juce::StringArray, NumParams> choiceLabels;
+    std::array<std::array<juce::String, NumBandParams>, MultiBandEQ::MaxBands> bandParamIds;
+    juce::StringArray bandTypeLabels;
+
+    // Instances can be prepared from several threads at once (e.g. one per track)
+    juce::CriticalSection lock;
+    std::map<double, std::shared_ptr<const ProgramCoefs>> programCoefs;
+    std::map<int, std::shared_ptr<const std::vector<double>>> logFreqGrids;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedResources)
+};
+
+/*! \brief Worker threads for the expensive part of prepareToPlay and the linear phase kernels, shared the same way
+    as SharedResources.
+    A few threads for the whole process: a session of 100 instances doesn't start 100 threads */
+class PrepareThreadPool : public juce::ThreadPool
+{
+public:
+    static constexpr int NumThreads = 2;
+    PrepareThreadPool() : juce::ThreadPool(NumThreads) {}
+};
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    Instantiation and editor-open benchmark, see StartupBenchmark.h
+
+  ==============================================================================
+*/
+
+#include "StartupBenchmark.h"
+#include "PluginProcessor.h"
+
+namespace {
+    constexpr int NumInstances = 200;
+    constexpr int NumPrepares = 20;
+    constexpr int NumEditors = 20;
+    constexpr double SampleRate = 48000.0;
+    constexpr int BlockSize = 512;
+
+    double GetMsSince(juce::int64 startTicks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+    }
+
+    /*! \brief prepareToPlay of a fresh instance, like a host's first, until its background job is done */
+    double TimePrepare(bool isLinearPhase)
+    {
+        Tutorial_EQAudioProcessor processor;
+        auto* phaseMode = processor.apvts.getParameter(ParamTable[PhaseMode].id);
+        phaseMode->setValueNotifyingHost(phaseMode->convertTo0to1((float) (isLinearPhase ? LinearPhase : MinimumPhase)));
+        processor.setPlayConfigDetails(2, 2, SampleRate, BlockSize);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        processor.prepareToPlay(SampleRate, BlockSize);
+        processor.waitForBackgroundPreparation();
+        return GetMsSince(start);
+    }
+}
+
+
+// Free functions
+
+StartupResult RunStartupBenchmark(int numInstances, int numPrepares, int numEditors)
+{
+    StartupResult result {};
+    result.editorOpenMs = result.firstPaintMs = -1.0;
+
+    // One at a time, like a host loading a session track by track
+    double totalConstruct = 0.0, totalDestruct = 0.0;
+    for (int i = 0; i < numInstances; i++) {
+        auto start = juce::Time::getHighResolutionTicks();
+        auto processor = std::make_unique<Tutorial_EQAudioProcessor>();
+        const double constructMs = GetMsSince(start);
+
+        start = juce::Time::getHighResolutionTicks();
+        processor.reset();
+        totalDestruct += GetMsSince(start);
+
+        totalConstruct += constructMs;
+        result.worstConstructMs = juce::jmax(result.worstConstructMs, constructMs);
+    }
+    result.constructMs = totalConstruct / juce::jmax(1, numInstances);
+    result.destructMs = totalDestruct / juce::jmax(1, numInstances);
+
+    // NOTE: The factory programs' coefficients are shared, only the first instance at a rate designs them
+    double totalPrepare = 0.0, totalLinearPrepare = 0.0;
+    for (int i = 0; i < numPrepares; i++) {
+        totalPrepare += TimePrepare(false);
+        const double linearMs = TimePrepare(true);
+        totalLinearPrepare += linearMs;
+        result.worstLinearPhasePrepareMs = juce::jmax(result.worstLinearPhasePrepareMs, linearMs);
+    }
+    result.prepareMs = totalPrepare / juce::jmax(1, numPrepares);
+    result.linearPhasePrepareMs = totalLinearPrepare / juce::jmax(1, numPrepares);
+
+    if (numEditors > 0 && juce::MessageManager::existsAndIsCurrentThread()) {
+        Tutorial_EQAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(SampleRate, BlockSize);
+
+        double totalOpen = 0.0, totalPaint = 0.0;
+        for (int i = 0; i < numEditors; i++) {
+            auto start = juce::Time::getHighResolutionTicks();
+            std::unique_ptr<juce::AudioProcessorEditor> editor(processor.createEditor());
+            totalOpen += GetMsSince(start);
+
+            // What the first frame of the window costs, without a window
+            juce::Image frame(juce::Image::ARGB, editor->getWidth(), editor->getHeight(), true);
+            juce::Graphics g(frame);
+            start = juce::Time::getHighResolutionTicks();
+            editor->paintEntireComponent(g, false);
+            totalPaint += GetMsSince(start);
+        }
+        result.editorOpenMs = totalOpen / numEditors;
+        result.firstPaintMs = totalPaint / numEditors;
+    }
+
+    result.passed = result.constructMs <= StartupBudgets::ConstructMs && result.destructMs <= StartupBudgets::DestructMs
+        && result.prepareMs <= StartupBudgets::PrepareMs && result.linearPhasePrepareMs <= StartupBudgets::LinearPhasePrepareMs
+        && result.editorOpenMs <= StartupBudgets::EditorOpenMs && result.firstPaintMs <= StartupBudgets::FirstPaintMs;
+    return result;
+}
+
+bool RunAllStartupBenchmarks()
+{
+    const auto r = RunStartupBenchmark(NumInstances, NumPrepares, NumEditors);
+    auto editorMs = [](double ms) { return ms >= 0.0 ? juce::String(ms, 3) + " ms" : juce::String("n/a"); };
+
+    juce::Logger::writeToLog(juce::String(r.passed ? "PASS " : "FAIL ")
+                             + "startup: construct " + juce::String(r.constructMs, 3) + " ms (worst " + juce::String(r.worstConstructMs, 3)
+                             + ", budget " + juce::String(StartupBudgets::ConstructMs, 1) + ")"
+                             + ", destruct " + juce::String(r.destructMs, 3) + " ms (budget " + juce::String(StartupBudgets::DestructMs, 1) + ")"
+                             + ", prepare " + juce::String(r.prepareMs, 3) + " ms (budget " + juce::String(StartupBudgets::PrepareMs, 1) + ")"
+                             + ", linear phase prepare " + juce::String(r.linearPhasePrepareMs, 3) + " ms (worst "
+                             + juce::String(r.worstLinearPhasePrepareMs, 3) + ", budget "
+                             + juce::String(StartupBudgets::LinearPhasePrepareMs, 1) + ")"
+                             + ", editor open " + editorMs(r.editorOpenMs) + " (budget " + juce::String(StartupBudgets::EditorOpenMs, 1) + ")"
+                             + ", first paint " + editorMs(r.firstPaintMs) + " (budget " + juce::String(StartupBudgets::FirstPaintMs, 1) + ")");
+    return r.passed;
+}
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    Instantiation and editor-open benchmark.
+
+    Hosts create (and often destroy right away) every plugin of a session
+    when loading or scanning it, and open editors on demand. This times
+    what they wait for: the processor's constructor and destructor, its
+    prepareToPlay, the editor's constructor, and its first paint (into an
+    offscreen image, so no window is needed), and checks each mean against
+    a budget.
+
+    prepareToPlay is timed twice on fresh instances, up to the end of the
+    job it queues: in minimum phase, and in linear phase, where it builds
+    the LinearPhaseEQ and designs its first kernel. Whatever the linear
+    phase engine starts to cost there (kernel design, threads, pool jobs)
+    shows up in that budget.
+
+    Runs in the Tutorial_EQ_Benchmarks console app, whose main thread is
+    the message thread: "Tutorial_EQ_Benchmarks startup" runs it alone.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+/*! \brief Mean times allowed, in ms. Over them the log line says FAIL */
+namespace StartupBudgets {
+    constexpr double ConstructMs = 1.0;
+    constexpr double DestructMs = 1.0;
+    constexpr double PrepareMs = 5.0;
+    constexpr double LinearPhasePrepareMs = 25.0; // Default FIR length (4096)
+    constexpr double EditorOpenMs = 10.0;
+    constexpr double FirstPaintMs = 10.0;
+}
+
+struct StartupResult {
+    double constructMs, destructMs;     // Processor, mean and worst
+    double worstConstructMs;
+    double prepareMs, linearPhasePrepareMs; // prepareToPlay and its background job, mean
+    double worstLinearPhasePrepareMs;
+    double editorOpenMs, firstPaintMs;  // -1 if not run (off the message thread)
+    bool passed;
+};
+
+/*! \brief Creates and destroys numInstances processors one after the other, prepares numPrepares fresh ones in
+    each phase mode, then opens and paints numEditors editors on one of them. Editors need the message thread,
+    they are skipped elsewhere */
+StartupResult RunStartupBenchmark(int numInstances, int numPrepares, int numEditors);
+
+/*! \brief Runs it and logs one line. Returns false if a budget was missed */
+bool RunAllStartupBenchmarks();
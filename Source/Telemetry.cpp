@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    Per block CPU timing, see Telemetry.h
+
+  ==============================================================================
+*/
+
+#include "Telemetry.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+#if TUTORIAL_EQ_ENABLE_TELEMETRY && JUCE_LINUX
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <signal.h>
+ #include <cerrno>
+#endif
+
+
+// Free functions
+
+juce::uint64 Telemetry::ReadCycleCounter() noexcept
+{
+   #if JUCE_INTEL
+    return (juce::uint64) __rdtsc();
+   #else
+    return (juce::uint64) juce::Time::getHighResolutionTicks();
+   #endif
+}
+
+
+#if TUTORIAL_EQ_ENABLE_TELEMETRY
+
+static double MeasureCyclesPerSecond()
+{
+   #if JUCE_INTEL
+    // Calibrate the TSC against the high resolution clock, once per segment
+    const auto ticksStart = juce::Time::getHighResolutionTicks();
+    const auto cyclesStart = Telemetry::ReadCycleCounter();
+    juce::Thread::sleep(20);
+    const auto cycles = Telemetry::ReadCycleCounter() - cyclesStart;
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - ticksStart);
+    return seconds > 0.0 ? (double) cycles / seconds : 0.0;
+   #else
+    return (double) juce::Time::getHighResolutionTicksPerSecond();
+   #endif
+}
+
+static void InitialiseSegment(Telemetry::Segment& s)
+{
+    s.version = Telemetry::Version;
+    s.maxInstances = Telemetry::MaxInstances;
+    s.slotSize = sizeof(Telemetry::Slot);
+    s.cyclesPerSecond = MeasureCyclesPerSecond();
+    s.magic.store(Telemetry::Magic, std::memory_order_release); // Readers wait for it
+}
+
+static juce::int32 GetProcessId()
+{
+   #if JUCE_LINUX
+    return (juce::int32) getpid();
+   #else
+    return 0;
+   #endif
+}
+
+static bool IsProcessAlive(juce::int32 pid)
+{
+   #if JUCE_LINUX
+    return pid == 0 || kill((pid_t) pid, 0) == 0 || errno != ESRCH;
+   #else
+    juce::ignoreUnused(pid);
+    return true;
+   #endif
+}
+
+
+// Class functions
+//==============================================================================
+TelemetrySegment::TelemetrySegment()
+{
+   #if JUCE_LINUX
+    // Whoever creates the object initialises it, the others only map it
+    int fd = shm_open(Telemetry::SegmentName, O_CREAT | O_EXCL | O_RDWR, 0644);
+    const bool isCreator = fd >= 0;
+    if (!isCreator) {
+        fd = shm_open(Telemetry::SegmentName, O_RDWR, 0644);
+    }
+
+    if (fd >= 0) {
+        // Mapping past the end of a smaller object (an older build's, or one not truncated yet) raises SIGBUS on access
+        struct stat st {};
+        const bool sized = isCreator ? ftruncate(fd, sizeof(Telemetry::Segment)) == 0
+                                     : fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(Telemetry::Segment);
+        void* mapped = sized ? mmap(nullptr, sizeof(Telemetry::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                             : MAP_FAILED;
+        close(fd); // The mapping stays valid
+
+        if (mapped != MAP_FAILED) {
+            segment = static_cast<Telemetry::Segment*>(mapped); // ftruncate zero fills it
+            if (isCreator) {
+                InitialiseSegment(*segment);
+            }
+            if (segment->magic.load(std::memory_order_acquire) == Telemetry::Magic
+                && segment->version == Telemetry::Version) {
+                return;
+            }
+            // Left by an incompatible build, or still being initialised: don't write into it
+            munmap(mapped, sizeof(Telemetry::Segment));
+            segment = nullptr;
+        }
+    }
+   #endif
+
+    // Only this process can read it then, but instances still record
+    localSegment = std::make_unique<Telemetry::Segment>();
+    segment = localSegment.get();
+    InitialiseSegment(*segment);
+}
+
+TelemetrySegment::~TelemetrySegment()
+{
+   #if JUCE_LINUX
+    // The object itself stays, so monitoring tools keep their mapping across plugin reloads
+    if (segment != nullptr && localSegment == nullptr) {
+        munmap(segment, sizeof(Telemetry::Segment));
+    }
+   #endif
+}
+
+Telemetry::Slot* TelemetrySegment::claimSlot()
+{
+    const auto pid = GetProcessId();
+
+    for (auto& slot : segment->slots) {
+        juce::uint32 expected = 0;
+        bool claimed = slot.inUse.compare_exchange_strong(expected, 1);
+
+        // Slot of a process that died without releasing it. Its pid is the token: only one reclaimer swaps it
+        if (!claimed) {
+            auto deadPid = slot.pid.load();
+            claimed = deadPid != 0 && !IsProcessAlive(deadPid) && slot.pid.compare_exchange_strong(deadPid, pid);
+        }
+
+        if (claimed) {
+            slot.pid = pid;
+            slot.numBlocks = 0;
+            slot.lastBlockCycles = 0;
+            slot.qualityTier = 0;
+            slot.tierChanges = 0;
+            slot.cpuLoad = 0.f;
+            for (auto& stage : slot.histograms) {
+                for (auto& bucket : stage) bucket.store(0, std::memory_order_relaxed);
+            }
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void TelemetrySegment::releaseSlot(Telemetry::Slot* slot)
+{
+    if (slot == nullptr) return;
+    slot->pid = 0;
+    slot->inUse = 0;
+}
+
+//==============================================================================
+InstanceTelemetry::InstanceTelemetry()
+{
+    slot = segment->claimSlot();
+}
+
+InstanceTelemetry::~InstanceTelemetry()
+{
+    segment->releaseSlot(slot);
+}
+
+void InstanceTelemetry::setBlockInfo(double sampleRate, int blockSize)
+{
+    if (slot == nullptr) return;
+    slot->sampleRate = sampleRate;
+    slot->blockSize = (juce::uint32) blockSize;
+}
+
+void InstanceTelemetry::record(TelemetryStage stage, juce::uint64 cycles) noexcept
+{
+    if (slot == nullptr) return;
+
+    int bucket = 0;
+    while ((cycles >>= 1) != 0 && bucket < Telemetry::NumBuckets - 1) {
+        ++bucket;
+    }
+
+    // NOTE: Only our audio thread writes this slot, so a relaxed load + store is enough (no locked RMW)
+    auto& count = slot->histograms[static_cast<int>(stage)][bucket];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void InstanceTelemetry::endBlock(juce::uint64 totalCycles) noexcept
+{
+    if (slot == nullptr) return;
+
+    record(TelemetryStage::Total, totalCycles);
+    slot->lastBlockCycles.store(totalCycles, std::memory_order_relaxed);
+    slot->numBlocks.store(slot->numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void InstanceTelemetry::recordTierChange(int tier, float load) noexcept
+{
+    if (slot == nullptr) return;
+
+    slot->cpuLoad.store(load, std::memory_order_relaxed);
+    slot->qualityTier.store(tier, std::memory_order_relaxed);
+    slot->tierChanges.store(slot->tierChanges.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+#endif
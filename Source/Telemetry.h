@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    Per block CPU timing of processBlock's stages, in lock-free histograms.
+
+    Every instance of the process writes into its own slot of one shared
+    segment (a POSIX shared memory object on Linux), so an external tool can
+    map it read-only and follow the live load of every loaded instance
+    without ever touching the audio thread.
+
+    Disabled by default: define TUTORIAL_EQ_ENABLE_TELEMETRY=1 (e.g. in the
+    Projucer's preprocessor definitions). When disabled, every class below is
+    empty and every call compiles to nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef TUTORIAL_EQ_ENABLE_TELEMETRY
+ #define TUTORIAL_EQ_ENABLE_TELEMETRY 0
+#endif
+
+
+enum class TelemetryStage {
+    ParamRead,
+    CoefUpdate,
+    ChainProcess,
+    Total,
+    NumStages
+};
+
+namespace Telemetry {
+    constexpr int NumBuckets = 40;     // Bucket b counts the blocks that took [2^b, 2^(b+1)) cycles
+    constexpr int MaxInstances = 256;
+    constexpr juce::uint32 Magic = 0x4d4c4554; // "TELM", written last by whoever creates the segment
+    constexpr juce::uint32 Version = 2;
+    constexpr const char* SegmentName = "/tutorial_eq_telemetry";
+    constexpr int NumStages = static_cast<int>(TelemetryStage::NumStages);
+
+    /*! \brief One instance's data. Only its audio thread writes it, readers may see a block half recorded */
+    struct Slot {
+        std::atomic<juce::uint32> inUse;
+        std::atomic<juce::int32> pid;          // Lets readers (and claimSlot) spot slots of dead processes
+        std::atomic<juce::uint32> blockSize;
+        std::atomic<double> sampleRate;        // With blockSize, gives the deadline of a block
+        std::atomic<juce::uint64> numBlocks;
+        std::atomic<juce::uint64> lastBlockCycles;
+        std::atomic<juce::uint64> histograms[NumStages][NumBuckets];
+        std::atomic<juce::int32> qualityTier;  // CpuGovernor's QualityTier, 0 is full quality
+        std::atomic<juce::uint32> tierChanges; // Since the slot was claimed
+        std::atomic<float> cpuLoad;            // Smoothed share of the block deadline, at the last tier change
+    };
+
+    /*! \brief Fixed layout, shared with the monitoring tools. Bump Version when it changes */
+    struct Segment {
+        std::atomic<juce::uint32> magic;
+        juce::uint32 version, maxInstances, slotSize;
+        double cyclesPerSecond;                // Converts the histogram buckets to seconds
+        Slot slots[MaxInstances];
+    };
+
+    static_assert(std::atomic<juce::uint64>::is_always_lock_free, "Atomics in shared memory must be lock free");
+
+    /*! \brief rdtsc on x86, high resolution ticks elsewhere */
+    juce::uint64 ReadCycleCounter() noexcept;
+}
+
+
+#if TUTORIAL_EQ_ENABLE_TELEMETRY
+
+/*! \brief The process-wide segment. Owned through juce::SharedResourcePointer, so the first instance maps
+    it and the last one unmaps it */
+class TelemetrySegment
+{
+public:
+    TelemetrySegment();
+    ~TelemetrySegment();
+
+    /*! \brief Returns nullptr if every slot is taken */
+    Telemetry::Slot* claimSlot();
+    void releaseSlot(Telemetry::Slot* slot);
+
+private:
+    Telemetry::Segment* segment { nullptr };
+    std::unique_ptr<Telemetry::Segment> localSegment; // When shared memory isn't available
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetrySegment)
+};
+
+/*! \brief One per processor, owns a slot of the segment */
+class InstanceTelemetry
+{
+public:
+    InstanceTelemetry();
+    ~InstanceTelemetry();
+
+    void setBlockInfo(double sampleRate, int blockSize);
+    void record(TelemetryStage stage, juce::uint64 cycles) noexcept;
+    void endBlock(juce::uint64 totalCycles) noexcept;
+    void recordTierChange(int tier, float load) noexcept;
+
+private:
+    juce::SharedResourcePointer<TelemetrySegment> segment;
+    Telemetry::Slot* slot { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InstanceTelemetry)
+};
+
+/*! \brief Times processBlock: each lap() records the cycles since the previous one under a stage,
+    whatever is left when it goes out of scope (early returns included) counts as ChainProcess */
+class StageTimer
+{
+public:
+    explicit StageTimer(InstanceTelemetry& t) noexcept
+        : telemetry(t), start(Telemetry::ReadCycleCounter()), last(start) {}
+
+    ~StageTimer()
+    {
+        lap(TelemetryStage::ChainProcess);
+        telemetry.endBlock(last - start);
+    }
+
+    void lap(TelemetryStage stage) noexcept
+    {
+        const auto now = Telemetry::ReadCycleCounter();
+        telemetry.record(stage, now - last);
+        last = now;
+    }
+
+private:
+    InstanceTelemetry& telemetry;
+    juce::uint64 start, last;
+};
+
+#else
+
+class InstanceTelemetry
+{
+public:
+    void setBlockInfo(double, int) {}
+    void recordTierChange(int, float) noexcept {}
+};
+
+class StageTimer
+{
+public:
+    explicit StageTimer(InstanceTelemetry&) noexcept {}
+    void lap(TelemetryStage) noexcept {}
+};
+
+#endif
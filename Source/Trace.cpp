@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    Timeline tracing, see Trace.h
+
+  ==============================================================================
+*/
+
+#include "Trace.h"
+
+#if TUTORIAL_EQ_ENABLE_TRACING
+
+namespace {
+    struct Event {
+        const char* name;
+        juce::int64 start, end;
+    };
+
+    enum BufferState { Free, Claimed, Released };
+
+    /*! \brief Written by one thread only. numWritten is published after the event, so the exporter
+        never reads an event that was never written */
+    struct ThreadBuffer {
+        std::atomic<int> state { Free }; // Released ones are still exported, until a new thread takes them over
+        char threadName[64] {};
+        std::atomic<juce::uint64> numWritten { 0 };
+        std::array<Event, Trace::EventsPerThread> events {};
+    };
+
+    // Static storage: claiming a buffer on a thread's first event must not allocate
+    std::array<ThreadBuffer, Trace::MaxThreads> buffers;
+
+    ThreadBuffer* TryClaim(BufferState from) noexcept
+    {
+        for (auto& buffer : buffers) {
+            int expected = from;
+            if (buffer.state.compare_exchange_strong(expected, Claimed)) {
+                buffer.numWritten.store(0, std::memory_order_release);
+                // Host audio threads aren't juce::Threads, they get a generic name
+                juce::String name;
+                if (juce::MessageManager::existsAndIsCurrentThread()) {
+                    name = "Message thread";
+                } else if (auto* thread = juce::Thread::getCurrentThread()) {
+                    name = thread->getThreadName();
+                }
+                name.copyToUTF8(buffer.threadName, sizeof(buffer.threadName));
+                return &buffer;
+            }
+        }
+        return nullptr;
+    }
+
+    ThreadBuffer* ClaimBuffer() noexcept
+    {
+        // Buffers of exited threads are only reused once every buffer was taken, so their events last
+        if (auto* buffer = TryClaim(Free)) return buffer;
+        return TryClaim(Released); // nullptr: more live threads than MaxThreads, their events are dropped
+    }
+
+    /*! \brief The calling thread's buffer, given back when the thread exits (e.g. a pool's worker) */
+    struct BufferOwner {
+        ThreadBuffer* buffer { ClaimBuffer() };
+        ~BufferOwner()
+        {
+            if (buffer != nullptr) buffer->state.store(Released);
+        }
+    };
+}
+
+
+// Free functions
+
+void Trace::Record(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+{
+    thread_local BufferOwner owner;
+    auto* buffer = owner.buffer;
+    if (buffer == nullptr) return;
+
+    const auto n = buffer->numWritten.load(std::memory_order_relaxed);
+    buffer->events[(size_t) (n % EventsPerThread)] = { name, startTicks, endTicks };
+    buffer->numWritten.store(n + 1, std::memory_order_release);
+}
+
+bool Trace::WriteChromeJson(const juce::File& file)
+{
+    const double microsPerTick = 1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond();
+
+    juce::MemoryOutputStream json;
+    json << "{\"traceEvents\":[";
+    bool isFirst = true;
+    auto separator = [&] { json << (isFirst ? "\n" : ",\n"); isFirst = false; };
+
+    for (int tid = 0; tid < MaxThreads; ++tid) {
+        const auto& buffer = buffers[(size_t) tid];
+        if (buffer.state.load() == Free) continue;
+
+        juce::String threadName(juce::CharPointer_UTF8(buffer.threadName));
+        if (threadName.isEmpty()) {
+            threadName = "Thread " + juce::String(tid);
+        }
+        separator();
+        json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+             << ",\"args\":{\"name\":" << juce::JSON::toString(threadName) << "}}";
+
+        const auto numWritten = buffer.numWritten.load(std::memory_order_acquire);
+        const auto first = numWritten > (juce::uint64) EventsPerThread ? numWritten - EventsPerThread : 0;
+        for (auto i = first; i < numWritten; ++i) {
+            const auto& event = buffer.events[(size_t) (i % EventsPerThread)];
+
+            // "X" is a complete event: start and duration, in microseconds
+            separator();
+            json << "{\"name\":" << juce::JSON::toString(juce::String(event.name))
+                 << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                 << ",\"ts\":" << juce::String((double) event.start * microsPerTick, 3)
+                 << ",\"dur\":" << juce::String((double) (event.end - event.start) * microsPerTick, 3) << "}";
+        }
+    }
+    json << "\n]}\n";
+
+    return file.replaceWithData(json.getData(), json.getDataSize());
+}
+
+#endif
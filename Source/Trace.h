@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    Timeline tracing of the audio and UI hot paths.
+
+    EQ_TRACE_SCOPE("name") records when the enclosing scope started and ended,
+    on which thread. Each thread writes into its own preallocated ring buffer,
+    without locks or allocation, so it can be used on the audio thread.
+    Trace::WriteChromeJson() exports what the buffers hold in the Chrome trace
+    format, which chrome://tracing and ui.perfetto.dev open.
+
+    Disabled by default: define TUTORIAL_EQ_ENABLE_TRACING=1 (e.g. in the
+    Projucer's preprocessor definitions). When disabled, EQ_TRACE_SCOPE expands
+    to nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef TUTORIAL_EQ_ENABLE_TRACING
+ #define TUTORIAL_EQ_ENABLE_TRACING 0
+#endif
+
+
+#if TUTORIAL_EQ_ENABLE_TRACING
+
+namespace Trace {
+    constexpr int MaxThreads = 16;
+    constexpr int EventsPerThread = 1 << 13; // Oldest events get overwritten. ~3s of 512 samples blocks at 48kHz, with UI events
+
+    /*! \brief name must be a string literal (or outlive the export), only the pointer is kept */
+    void Record(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept;
+
+    /*! \brief Writes every thread's events in the Chrome trace JSON format. Meant for the message thread,
+        events recorded during the export may come out torn */
+    bool WriteChromeJson(const juce::File& file);
+
+    class ScopedEvent
+    {
+    public:
+        explicit ScopedEvent(const char* eventName) noexcept
+            : name(eventName), start(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedEvent() { Record(name, start, juce::Time::getHighResolutionTicks()); }
+
+    private:
+        const char* name;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedEvent)
+    };
+}
+
+ #define EQ_TRACE_SCOPE(name) Trace::ScopedEvent JUCE_JOIN_MACRO (traceEvent_, __LINE__) (name)
+
+#else
+
+ #define EQ_TRACE_SCOPE(name)
+
+#endif
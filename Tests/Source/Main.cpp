@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    Tutorial_EQ_Tests: runs the null tests (NullTest.h) and the design tests
+    (DesignTest.h) headless, with no host. Logs one line per run and exits
+    with 1 if any failed, so a build script can gate on it.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/NullTest.h"
+#include "../../Source/DesignTest.h"
+
+namespace {
+    /*! \brief writeToLog goes to the debugger by default, a console run wants it on stdout */
+    class ConsoleLogger : public juce::Logger
+    {
+        void logMessage(const juce::String& message) override { std::cout << message << std::endl; }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ignoreUnused(argc, argv);
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // The processor posts async updates, it needs a MessageManager
+    ConsoleLogger logger;
+    juce::Logger::setCurrentLogger(&logger);
+
+    // Both run, even if the first fails
+    const bool nullTestsPassed = RunAllNullTests();
+    const bool designTestsPassed = RunAllDesignTests();
+    const bool passed = nullTestsPassed && designTestsPassed;
+    juce::Logger::writeToLog(passed ? "All tests passed" : "Tests FAILED");
+
+    juce::Logger::setCurrentLogger(nullptr);
+    return passed ? 0 : 1;
+}